@@ -1,6 +1,17 @@
 #ifndef CRAFTWORLD_H_
 #define CRAFTWORLD_H_
 
+#include "../../src/compression.h"
 #include "../../src/craftworld_base.h"
+#include "../../src/frame_stack.h"
+#include "../../src/level_generator.h"
+#include "../../src/level_registry.h"
+#include "../../src/level_set.h"
+#include "../../src/level_stream.h"
+#include "../../src/recorder.h"
+#include "../../src/render.h"
+#include "../../src/state_archive.h"
+#include "../../src/state_view.h"
+#include "../../src/trajectory_log.h"
 
 #endif    // CRAFTWORLD_H_
\ No newline at end of file
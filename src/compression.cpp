@@ -0,0 +1,367 @@
+#include "compression.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "snapshot.h"
+
+namespace craftworld {
+
+namespace {
+// First byte of every compressed snapshot
+enum class CodingTag : uint8_t {
+    kStandalone = 0,    // All fields are stored
+    kPrevious = 1,      // Only the changes since the previous snapshot are stored
+};
+
+constexpr uint8_t kVarintMask = 0x7F;
+constexpr uint8_t kVarintContinue = 0x80;
+constexpr int kVarintShift = 7;
+constexpr int kMaxVarintBits = 64;
+
+void put_u64(uint64_t value, std::vector<uint8_t> &out) {
+    for (std::size_t i = 0; i < sizeof(value); ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));    // NOLINT(*-magic-numbers)
+    }
+}
+
+auto get_u8(const uint8_t *&data, const uint8_t *end) -> uint8_t {
+    if (data == end) {
+        throw std::invalid_argument("Compressed snapshot is truncated.");
+    }
+    return *data++;
+}
+
+auto get_u64(const uint8_t *&data, const uint8_t *end) -> uint64_t {
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < sizeof(value); ++i) {
+        value |= static_cast<uint64_t>(get_u8(data, end)) << (8 * i);    // NOLINT(*-magic-numbers)
+    }
+    return value;
+}
+
+// Varint narrowed to T, out of range values are rejected instead of truncated
+template <typename T>
+auto get_narrow_varint(const uint8_t *&data, const uint8_t *end) -> T {
+    const uint64_t value = get_varint(data, end);
+    if (value > std::numeric_limits<T>::max()) {
+        throw std::invalid_argument("Value out of range in compressed snapshot.");
+    }
+    return static_cast<T>(value);
+}
+
+auto get_element(const uint8_t *&data, const uint8_t *end) -> uint8_t {
+    const uint8_t el = get_u8(data, end);
+    if (el >= kNumElements) {
+        throw std::invalid_argument("Unknown element type in compressed snapshot.");
+    }
+    return el;
+}
+
+auto read_header(const uint8_t *snapshot, std::size_t size) -> SnapshotHeader {
+    SnapshotHeader header;
+    if (snapshot == nullptr || size < sizeof(header)) {
+        throw std::invalid_argument("Snapshot is too small.");
+    }
+    std::memcpy(&header, snapshot, sizeof(header));
+    if (header.magic != kSnapshotMagic || size < sizeof(header) + header.grid_size) {
+        throw std::invalid_argument("Invalid snapshot header.");
+    }
+    return header;
+}
+
+auto board_size(const SnapshotHeader &header) noexcept -> std::size_t {
+    return static_cast<std::size_t>(header.rows) * header.cols;
+}
+
+// Cells are stored as (varint gap since the previous stored cell, element)
+class CellWriter {
+public:
+    explicit CellWriter(std::vector<uint8_t> &out) noexcept : out_(out) {}
+    void put(std::size_t index, uint8_t el) {
+        put_varint(index - next_index_, out_);
+        out_.push_back(el);
+        next_index_ = index + 1;
+    }
+
+private:
+    std::vector<uint8_t> &out_;
+    std::size_t next_index_ = 0;
+};
+
+class CellReader {
+public:
+    CellReader(std::size_t board_size, const uint8_t *&data, const uint8_t *end) noexcept
+        : board_size_(board_size), data_(data), end_(end) {}
+    auto next() -> std::size_t {
+        const uint64_t index = next_index_ + get_varint(data_, end_);
+        if (index >= board_size_) {
+            throw std::invalid_argument("Cell index out of range in compressed snapshot.");
+        }
+        next_index_ = index + 1;
+        return static_cast<std::size_t>(index);
+    }
+
+private:
+    std::size_t board_size_;
+    const uint8_t *&data_;
+    const uint8_t *end_;
+    uint64_t next_index_ = 0;
+};
+
+void read_inventory(SnapshotHeader &header, const uint8_t *&data, const uint8_t *end) {
+    const uint64_t num_items = get_varint(data, end);
+    for (uint64_t i = 0; i < num_items; ++i) {
+        const uint8_t el = get_element(data, end);
+        const uint64_t count = get_varint(data, end);
+        if (count > UINT16_MAX) {
+            throw std::invalid_argument("Inventory count out of range in compressed snapshot.");
+        }
+        header.inventory[el] = static_cast<uint16_t>(count);    // NOLINT(*-constant-array-index)
+    }
+}
+}    // namespace
+
+void put_varint(uint64_t value, std::vector<uint8_t> &out) {
+    while (value >= kVarintContinue) {
+        out.push_back(static_cast<uint8_t>(value | kVarintContinue));
+        value >>= kVarintShift;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+auto get_varint(const uint8_t *&data, const uint8_t *end) -> uint64_t {
+    uint64_t value = 0;
+    for (int shift = 0; shift < kMaxVarintBits; shift += kVarintShift) {
+        if (data == end) {
+            throw std::invalid_argument("Varint is truncated.");
+        }
+        const uint8_t byte = *data++;
+        value |= static_cast<uint64_t>(byte & kVarintMask) << shift;
+        if ((byte & kVarintContinue) == 0) {
+            return value;
+        }
+    }
+    throw std::invalid_argument("Varint is too long.");
+}
+
+void compress_snapshot(const uint8_t *snapshot, std::size_t size, std::vector<uint8_t> &out, const uint8_t *previous,
+                       std::size_t previous_size) {
+    const SnapshotHeader header = read_header(snapshot, size);
+    const uint8_t *grid = snapshot + sizeof(header);
+    const std::size_t num_cells = board_size(header);
+    if ((header.grid_encoding == SnapshotGridEncoding::kRaw && header.grid_size != num_cells) ||
+        (header.grid_encoding == SnapshotGridEncoding::kDelta && header.grid_size % kDeltaEntrySize != 0)) {
+        throw std::invalid_argument("Snapshot size does not match its board dimensions.");
+    }
+
+    if (previous != nullptr) {
+        const SnapshotHeader prev_header = read_header(previous, previous_size);
+        const uint8_t *prev_grid = previous + sizeof(prev_header);
+        if (prev_header.level_id == header.level_id && prev_header.rows == header.rows &&
+            prev_header.cols == header.cols && prev_header.goal == header.goal &&
+            prev_header.grid_encoding == SnapshotGridEncoding::kRaw && prev_header.grid_size == num_cells &&
+            header.grid_encoding == SnapshotGridEncoding::kRaw) {
+            out.push_back(static_cast<uint8_t>(CodingTag::kPrevious));
+            put_u64(header.zorb_hash, out);
+            put_varint(header.reward_signal, out);
+            put_varint(header.agent_idx, out);
+            out.push_back(header.current_reward);
+            // Changed inventory counts
+            std::size_t num_items = 0;
+            for (std::size_t el = 0; el < kNumElements; ++el) {
+                num_items += static_cast<std::size_t>(header.inventory[el] != prev_header.inventory[el]);
+            }
+            put_varint(num_items, out);
+            for (std::size_t el = 0; el < kNumElements; ++el) {
+                if (header.inventory[el] != prev_header.inventory[el]) {
+                    out.push_back(static_cast<uint8_t>(el));
+                    put_varint(header.inventory[el], out);    // NOLINT(*-constant-array-index)
+                }
+            }
+            // Changed cells
+            std::size_t num_changed = 0;
+            for (std::size_t i = 0; i < num_cells; ++i) {
+                num_changed += static_cast<std::size_t>(grid[i] != prev_grid[i]);
+            }
+            put_varint(num_changed, out);
+            CellWriter cells(out);
+            for (std::size_t i = 0; i < num_cells; ++i) {
+                if (grid[i] != prev_grid[i]) {
+                    cells.put(i, grid[i]);
+                }
+            }
+            return;
+        }
+    }
+
+    out.push_back(static_cast<uint8_t>(CodingTag::kStandalone));
+    put_varint(header.rows, out);
+    put_varint(header.cols, out);
+    put_u64(header.level_id, out);
+    put_u64(header.zorb_hash, out);
+    put_varint(header.reward_signal, out);
+    put_varint(header.agent_idx, out);
+    out.push_back(header.current_reward);
+    out.push_back(static_cast<uint8_t>(header.grid_encoding));
+    out.push_back(header.goal);
+    // Non-zero inventory counts
+    std::size_t num_items = 0;
+    for (const uint16_t count : header.inventory) {
+        num_items += static_cast<std::size_t>(count > 0);
+    }
+    put_varint(num_items, out);
+    for (std::size_t el = 0; el < kNumElements; ++el) {
+        if (header.inventory[el] > 0) {    // NOLINT(*-constant-array-index)
+            out.push_back(static_cast<uint8_t>(el));
+            put_varint(header.inventory[el], out);    // NOLINT(*-constant-array-index)
+        }
+    }
+
+    if (header.grid_encoding == SnapshotGridEncoding::kRaw) {
+        // Runs of (element, varint length)
+        for (std::size_t i = 0; i < num_cells;) {
+            std::size_t run_end = i + 1;
+            while (run_end < num_cells && grid[run_end] == grid[i]) {
+                ++run_end;
+            }
+            out.push_back(grid[i]);
+            put_varint(run_end - i, out);
+            i = run_end;
+        }
+    } else {
+        // Delta entries, which snapshot_into() writes in increasing index order
+        const std::size_t num_entries = header.grid_size / kDeltaEntrySize;
+        put_varint(num_entries, out);
+        CellWriter cells(out);
+        std::size_t next_index = 0;
+        for (std::size_t i = 0; i < num_entries; ++i) {
+            const uint8_t *entry = grid + (kDeltaEntrySize * i);
+            const std::size_t index = static_cast<std::size_t>(entry[0]) | (static_cast<std::size_t>(entry[1]) << 8);
+            if (index < next_index) {
+                throw std::invalid_argument("Delta snapshot entries are not in increasing index order.");
+            }
+            cells.put(index, entry[2]);
+            next_index = index + 1;
+        }
+    }
+}
+
+auto decompress_snapshot(const uint8_t *data, std::size_t size, std::vector<uint8_t> &snapshot,
+                         const uint8_t *previous, std::size_t previous_size) -> std::size_t {
+    const uint8_t *pos = data;
+    const uint8_t *end = data + size;
+    const auto tag = static_cast<CodingTag>(get_u8(pos, end));
+    SnapshotHeader header;
+
+    if (tag == CodingTag::kPrevious) {
+        if (previous == nullptr) {
+            throw std::invalid_argument("Compressed snapshot needs the previous snapshot to decompress.");
+        }
+        header = read_header(previous, previous_size);
+        if (header.grid_encoding != SnapshotGridEncoding::kRaw || header.grid_size != board_size(header)) {
+            throw std::invalid_argument("Previous snapshot does not store the full board.");
+        }
+        header.zorb_hash = get_u64(pos, end);
+        header.reward_signal = get_varint(pos, end);
+        header.agent_idx = get_narrow_varint<uint32_t>(pos, end);
+        header.current_reward = get_u8(pos, end);
+        read_inventory(header, pos, end);
+
+        snapshot.resize(sizeof(header) + header.grid_size);
+        uint8_t *grid = snapshot.data() + sizeof(header);
+        std::memcpy(grid, previous + sizeof(header), header.grid_size);
+        const uint64_t num_changed = get_varint(pos, end);
+        CellReader cells(board_size(header), pos, end);
+        for (uint64_t i = 0; i < num_changed; ++i) {
+            const std::size_t index = cells.next();
+            grid[index] = get_element(pos, end);
+        }
+    } else if (tag == CodingTag::kStandalone) {
+        header.rows = get_narrow_varint<uint16_t>(pos, end);
+        header.cols = get_narrow_varint<uint16_t>(pos, end);
+        header.level_id = get_u64(pos, end);
+        header.zorb_hash = get_u64(pos, end);
+        header.reward_signal = get_varint(pos, end);
+        header.agent_idx = get_narrow_varint<uint32_t>(pos, end);
+        header.current_reward = get_u8(pos, end);
+        header.grid_encoding = static_cast<SnapshotGridEncoding>(get_u8(pos, end));
+        header.goal = get_element(pos, end);
+        read_inventory(header, pos, end);
+
+        const std::size_t num_cells = board_size(header);
+        if (header.grid_encoding == SnapshotGridEncoding::kRaw) {
+            header.grid_size = static_cast<uint32_t>(num_cells);
+            snapshot.resize(sizeof(header) + num_cells);
+            uint8_t *grid = snapshot.data() + sizeof(header);
+            for (std::size_t i = 0; i < num_cells;) {
+                const uint8_t el = get_element(pos, end);
+                const uint64_t run_length = get_varint(pos, end);
+                if (run_length == 0 || run_length > num_cells - i) {
+                    throw std::invalid_argument("Run length out of range in compressed snapshot.");
+                }
+                std::memset(grid + i, el, static_cast<std::size_t>(run_length));
+                i += static_cast<std::size_t>(run_length);
+            }
+        } else if (header.grid_encoding == SnapshotGridEncoding::kDelta) {
+            const uint64_t num_entries = get_varint(pos, end);
+            if (num_entries > num_cells) {
+                throw std::invalid_argument("Too many delta entries in compressed snapshot.");
+            }
+            header.grid_size = static_cast<uint32_t>(3 * num_entries);
+            snapshot.resize(sizeof(header) + header.grid_size);
+            uint8_t *entry = snapshot.data() + sizeof(header);
+            CellReader cells(num_cells, pos, end);
+            for (uint64_t i = 0; i < num_entries; ++i) {
+                const std::size_t index = cells.next();
+                *entry++ = static_cast<uint8_t>(index & 0xFF);           // NOLINT(*-magic-numbers)
+                *entry++ = static_cast<uint8_t>((index >> 8) & 0xFF);    // NOLINT(*-magic-numbers)
+                *entry++ = get_element(pos, end);
+            }
+        } else {
+            throw std::invalid_argument("Unknown grid encoding in compressed snapshot.");
+        }
+    } else {
+        throw std::invalid_argument("Unknown compressed snapshot coding.");
+    }
+
+    if (header.agent_idx >= board_size(header)) {
+        throw std::invalid_argument("Agent index out of range in compressed snapshot.");
+    }
+    std::memcpy(snapshot.data(), &header, sizeof(header));
+    return static_cast<std::size_t>(pos - data);
+}
+
+auto compress_trajectory(const std::vector<CraftWorldGameState> &states) -> std::vector<uint8_t> {
+    std::vector<uint8_t> out;
+    put_varint(states.size(), out);
+    std::vector<uint8_t> snapshot;
+    std::vector<uint8_t> previous;
+    for (const auto &state : states) {
+        snapshot.resize(state.snapshot_size());
+        state.snapshot_into(snapshot.data(), snapshot.size());
+        compress_snapshot(snapshot.data(), snapshot.size(), out, previous.empty() ? nullptr : previous.data(),
+                          previous.size());
+        std::swap(snapshot, previous);
+    }
+    return out;
+}
+
+auto decompress_trajectory(const uint8_t *data, std::size_t size) -> std::vector<std::vector<uint8_t>> {
+    const uint8_t *pos = data;
+    const uint8_t *end = data + size;
+    const uint64_t num_states = get_varint(pos, end);
+    std::vector<std::vector<uint8_t>> snapshots;
+    for (uint64_t i = 0; i < num_states; ++i) {
+        std::vector<uint8_t> snapshot;
+        const std::vector<uint8_t> *previous = snapshots.empty() ? nullptr : &snapshots.back();
+        pos += decompress_snapshot(pos, static_cast<std::size_t>(end - pos), snapshot,
+                                   previous == nullptr ? nullptr : previous->data(),
+                                   previous == nullptr ? 0 : previous->size());
+        snapshots.push_back(std::move(snapshot));
+    }
+    return snapshots;
+}
+
+}    // namespace craftworld
@@ -0,0 +1,76 @@
+#ifndef CRAFTWORLD_COMPRESSION_H_
+#define CRAFTWORLD_COMPRESSION_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "craftworld_base.h"
+
+namespace craftworld {
+
+// Dependency-free compression of state snapshots (see CraftWorldGameState::snapshot()).
+// Header fields are varint coded, raw grids are run-length coded and delta grids store varint index gaps.
+// A snapshot can also be coded against the previous snapshot of a trajectory, storing only what changed.
+
+/**
+ * Append an unsigned LEB128 varint.
+ * @param value Value to encode
+ * @param out Vector to append to
+ */
+void put_varint(uint64_t value, std::vector<uint8_t> &out);
+
+/**
+ * Read an unsigned LEB128 varint.
+ * @param data Read position, advanced past the varint
+ * @param end End of the readable bytes
+ * @return decoded value
+ * @throw std::invalid_argument if the varint is truncated or too long
+ */
+auto get_varint(const uint8_t *&data, const uint8_t *end) -> uint64_t;
+
+/**
+ * Compress a snapshot, appending the compressed bytes to out.
+ * If a previous snapshot of the same level is given and both snapshots store the full board (kRaw), only the changes
+ * since the previous snapshot are stored, and the same previous snapshot is needed to decompress.
+ * @param snapshot Pointer to the snapshot bytes
+ * @param size Number of snapshot bytes
+ * @param out Vector to append the compressed bytes to
+ * @param previous Pointer to the previous snapshot bytes, or nullptr
+ * @param previous_size Number of previous snapshot bytes
+ * @throw std::invalid_argument if a snapshot is malformed
+ */
+void compress_snapshot(const uint8_t *snapshot, std::size_t size, std::vector<uint8_t> &out,
+                       const uint8_t *previous = nullptr, std::size_t previous_size = 0);
+
+/**
+ * Decompress one snapshot written by compress_snapshot().
+ * @param data Pointer to the compressed bytes
+ * @param size Number of readable bytes, may extend past the compressed snapshot
+ * @param snapshot Vector to store the decompressed snapshot in
+ * @param previous Pointer to the previous snapshot bytes used when compressing, or nullptr
+ * @param previous_size Number of previous snapshot bytes
+ * @return number of compressed bytes read
+ * @throw std::invalid_argument if the data is malformed or needs a previous snapshot which is not given
+ */
+auto decompress_snapshot(const uint8_t *data, std::size_t size, std::vector<uint8_t> &snapshot,
+                         const uint8_t *previous = nullptr, std::size_t previous_size = 0) -> std::size_t;
+
+/**
+ * Compress consecutive states of a trajectory, each state coded against the previous one.
+ * @param states States of the trajectory, all from the same level
+ * @return compressed bytes
+ */
+[[nodiscard]] auto compress_trajectory(const std::vector<CraftWorldGameState> &states) -> std::vector<uint8_t>;
+
+/**
+ * Decompress a trajectory written by compress_trajectory().
+ * @param data Pointer to the compressed bytes
+ * @param size Number of compressed bytes
+ * @return snapshot of each state (kRaw), which can be read with StateView or CraftWorldGameState::from_snapshot()
+ * @throw std::invalid_argument if the data is malformed
+ */
+[[nodiscard]] auto decompress_trajectory(const uint8_t *data, std::size_t size) -> std::vector<std::vector<uint8_t>>;
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_COMPRESSION_H_
@@ -3,15 +3,20 @@
 #include <nop/serializer.h>
 #include <nop/utility/buffer_reader.h>
 #include <nop/utility/buffer_writer.h>
-#include <nop/utility/stream_reader.h>
-#include <nop/utility/stream_writer.h>
 
 #include <algorithm>
+#include <charconv>
 #include <cstdint>
-#include <sstream>
+#include <cstring>
+#include <map>
+#include <mutex>
 #include <type_traits>
 
 #include "definitions.h"
+#include "level_registry.h"
+#include "observation.h"
+#include "snapshot.h"
+#include "sprite_atlas.h"
 #include "util.h"
 
 namespace craftworld {
@@ -29,13 +34,72 @@ namespace {
 }
 }    // namespace
 
+auto get_zobrist_table(std::size_t board_size, std::size_t max_inventory_items) -> std::shared_ptr<const ZobristTable> {
+    static std::mutex mutex;
+    static std::map<std::pair<std::size_t, std::size_t>, std::shared_ptr<const ZobristTable>> cache;
+    const std::lock_guard<std::mutex> lock(mutex);
+    auto &table = cache[{board_size, max_inventory_items}];
+    if (table) {
+        return table;
+    }
+
+    auto new_table = std::make_shared<ZobristTable>();
+    new_table->world.resize(kNumElements * board_size);
+    new_table->inventory.resize(kNumElements * max_inventory_items);
+    std::mt19937 gen(static_cast<std::mt19937::result_type>(0));
+    std::uniform_int_distribution<uint64_t> dist(0);
+    // Zorbist hashing for board
+    for (auto &key : new_table->world) {
+        key = dist(gen);
+    }
+    // Zorbist hashing for inventory
+    for (auto &key : new_table->inventory) {
+        key = dist(gen);
+    }
+    table = std::move(new_table);
+    return table;
+}
+
+SharedStateInfo::SharedStateInfo(const GameParameters &params)
+    : SharedStateInfo(std::get<std::string>(params.at("game_board_str")), std::get<bool>(params.at("workshop_swap"))) {
+}
+
+SharedStateInfo::SharedStateInfo(std::string board_str, bool workshop_swap_)
+    : game_board_str(std::move(board_str)), workshop_swap(workshop_swap_) {
+    init();
+}
+
+SharedStateInfo::SharedStateInfo(std::string board_str, bool workshop_swap_, Board board)
+    : game_board_str(std::move(board_str)),
+      initial_board(std::move(board)),
+      level_id(util::level_id(game_board_str, workshop_swap_)),
+      workshop_swap(workshop_swap_) {
+    zrbht = get_zobrist_table(initial_board.rows * initial_board.cols, MAX_INV_HASH_ITEMS);
+}
+
+void SharedStateInfo::init() {
+    initial_board = util::parse_board_str(game_board_str);
+    level_id = util::level_id(game_board_str, workshop_swap);
+    const std::size_t board_size = initial_board.rows * initial_board.cols;
+    zrbht = get_zobrist_table(board_size, MAX_INV_HASH_ITEMS);
+
+    // Set initial hash for game world
+    for (std::size_t i = 0; i < board_size; ++i) {
+        initial_board.zorb_hash ^= zrbht->world.at((static_cast<std::size_t>(initial_board.item(i)) * board_size) + i);
+    }
+}
+
 auto LocalState::operator==(const LocalState &other) const noexcept -> bool {
     return inventory == other.inventory;
 }
 
 CraftWorldGameState::CraftWorldGameState(const GameParameters &params)
-    : shared_state_ptr(std::make_shared<SharedStateInfo>(params)),
-      board(util::parse_board_str(std::get<std::string>(params.at("game_board_str")))) {
+    : shared_state_ptr(LevelRegistry::instance().intern(params)) {
+    reset();
+}
+
+CraftWorldGameState::CraftWorldGameState(std::shared_ptr<const SharedStateInfo> shared_state)
+    : shared_state_ptr(std::move(shared_state)) {
     reset();
 }
 
@@ -53,76 +117,209 @@ const std::vector<Action> CraftWorldGameState::ALL_ACTIONS = {Action::kUp, Actio
 // ---------------------------------------------------------------------------
 
 CraftWorldGameState::CraftWorldGameState(const std::vector<uint8_t> &byte_data)
-    : shared_state_ptr(std::make_shared<SharedStateInfo>()) {
-    std::stringstream ss;
-    ss.write(reinterpret_cast<char const *>(byte_data.data()), std::streamsize(byte_data.size()));
-    nop::Deserializer<nop::StreamReader<std::stringstream>> deserializer{std::move(ss)};
-    deserializer.Read(&local_state);
-    SharedStateInfo &info = *shared_state_ptr;
-    deserializer.Read(&info);
-    deserializer.Read(&board);
-    InitZrbhtTable();
+    : CraftWorldGameState(byte_data.data(), byte_data.size()) {}
+
+CraftWorldGameState::CraftWorldGameState(const uint8_t *data, std::size_t size) {
+    nop::Deserializer<nop::BufferReader> deserializer{data, size};
+    SharedStateInfo info;
+    if (!deserializer.Read(&local_state) || !deserializer.Read(&info) || !deserializer.Read(&board)) {
+        throw std::invalid_argument("Invalid serialized state.");
+    }
+    // Attach to the shared level information, which is only built the first time the level is seen
+    shared_state_ptr = LevelRegistry::instance().intern(info.game_board_str, info.workshop_swap);
+    if (shared_state_ptr->MAX_INV_HASH_ITEMS != info.MAX_INV_HASH_ITEMS) {
+        info.init();
+        shared_state_ptr = std::make_shared<const SharedStateInfo>(std::move(info));
+    }
 }
 
 auto CraftWorldGameState::serialize() const -> std::vector<uint8_t> {
-    nop::Serializer<nop::StreamWriter<std::stringstream>> serializer;
+    std::vector<uint8_t> byte_data;
+    serialize_into(byte_data);
+    return byte_data;
+}
+
+auto CraftWorldGameState::serialized_size() const noexcept -> std::size_t {
+    return nop::Encoding<LocalState>::Size(local_state) + nop::Encoding<SharedStateInfo>::Size(*shared_state_ptr) +
+           nop::Encoding<Board>::Size(board);
+}
+
+void CraftWorldGameState::serialize_into(std::vector<uint8_t> &byte_data) const {
+    byte_data.resize(serialized_size());
+    serialize_into(byte_data.data(), byte_data.size());
+}
+
+auto CraftWorldGameState::serialize_into(uint8_t *out, std::size_t size) const -> std::size_t {
+    const std::size_t num_bytes = serialized_size();
+    if (size < num_bytes) {
+        throw std::invalid_argument("Buffer is too small for the serialized state.");
+    }
+    nop::Serializer<nop::BufferWriter> serializer{out, num_bytes};
     serializer.Write(local_state);
     const SharedStateInfo &info = *shared_state_ptr;
     serializer.Write(info);
     serializer.Write(board);
-    auto &ss = serializer.writer().stream();
-    // discover size of data in stream
-    ss.seekg(0, std::ios::beg);
-    auto bof = ss.tellg();
-    ss.seekg(0, std::ios::end);
-    auto stream_size = std::size_t(ss.tellg() - bof);
-    ss.seekg(0, std::ios::beg);
-
-    // make your vector long enough
-    std::vector<uint8_t> byte_data(stream_size);
-
-    // read directly in
-    ss.read(reinterpret_cast<char *>(byte_data.data()), std::streamsize(byte_data.size()));
-    return byte_data;
+    return num_bytes;
 }
 
-void CraftWorldGameState::InitZrbhtTable() noexcept {
-    const std::size_t board_size = board.rows * board.cols;
+auto CraftWorldGameState::level_id() const noexcept -> uint64_t {
+    return shared_state_ptr->level_id;
+}
 
-    // Zorbist hashing for board
-    std::mt19937 gen(static_cast<std::mt19937::result_type>(0));
-    std::uniform_int_distribution<uint64_t> dist(0);
-    for (std::size_t channel = 0; channel < kNumElements; ++channel) {
+auto CraftWorldGameState::shared_state() const noexcept -> const std::shared_ptr<const SharedStateInfo> & {
+    return shared_state_ptr;
+}
+
+namespace {
+constexpr std::size_t kMaxDeltaBoardSize = std::size_t{1} << 16;
+
+auto count_changed_cells(const Board &board, const Board &initial_board) noexcept -> std::size_t {
+    std::size_t num_changed = 0;
+    for (std::size_t i = 0; i < board.grid.size(); ++i) {
+        num_changed += static_cast<std::size_t>(board.grid[i] != initial_board.grid[i]);
+    }
+    return num_changed;
+}
+}    // namespace
+
+auto CraftWorldGameState::snapshot_size(SnapshotGridEncoding encoding) const noexcept -> std::size_t {
+    if (encoding == SnapshotGridEncoding::kDelta) {
+        return sizeof(SnapshotHeader) +
+               (kDeltaEntrySize * count_changed_cells(board, shared_state_ptr->initial_board));
+    }
+    return sizeof(SnapshotHeader) + board.grid.size();
+}
+
+auto CraftWorldGameState::snapshot(SnapshotGridEncoding encoding) const -> std::vector<uint8_t> {
+    std::vector<uint8_t> bytes(snapshot_size(encoding));
+    snapshot_into(bytes.data(), bytes.size(), encoding);
+    return bytes;
+}
+
+auto CraftWorldGameState::snapshot_into(uint8_t *out, std::size_t size, SnapshotGridEncoding encoding) const
+    -> std::size_t {
+    if (board.rows > UINT16_MAX || board.cols > UINT16_MAX ||
+        (encoding == SnapshotGridEncoding::kDelta && board.grid.size() > kMaxDeltaBoardSize)) {
+        throw std::invalid_argument("Board is too large for the snapshot encoding.");
+    }
+    const std::size_t num_bytes = snapshot_size(encoding);
+    if (size < num_bytes) {
+        throw std::invalid_argument("Buffer is too small for the state snapshot.");
+    }
+    SnapshotHeader header;
+    header.rows = static_cast<uint16_t>(board.rows);
+    header.cols = static_cast<uint16_t>(board.cols);
+    header.level_id = shared_state_ptr->level_id;
+    header.zorb_hash = board.zorb_hash;
+    header.reward_signal = local_state.reward_signal;
+    header.agent_idx = static_cast<uint32_t>(board.agent_idx);
+    header.current_reward = local_state.current_reward;
+    header.grid_encoding = encoding;
+    header.goal = static_cast<uint8_t>(board.goal);
+    for (const auto &[element, count] : local_state.inventory) {
+        if (count > UINT16_MAX) {
+            throw std::invalid_argument("Inventory count is too large for the snapshot encoding.");
+        }
+        header.inventory[static_cast<std::size_t>(element)] = static_cast<uint16_t>(count);
+    }
+    header.grid_size = static_cast<uint32_t>(num_bytes - sizeof(header));
+    std::memcpy(out, &header, sizeof(header));
+
+    uint8_t *grid = out + sizeof(header);
+    if (encoding == SnapshotGridEncoding::kDelta) {
+        const Board &initial_board = shared_state_ptr->initial_board;
+        for (std::size_t i = 0; i < board.grid.size(); ++i) {
+            if (board.grid[i] != initial_board.grid[i]) {
+                *grid++ = static_cast<uint8_t>(i & 0xFF);           // NOLINT(*-magic-numbers)
+                *grid++ = static_cast<uint8_t>((i >> 8) & 0xFF);    // NOLINT(*-magic-numbers)
+                *grid++ = static_cast<uint8_t>(board.grid[i]);
+            }
+        }
+    } else {
+        for (std::size_t i = 0; i < board.grid.size(); ++i) {
+            grid[i] = static_cast<uint8_t>(board.grid[i]);
+        }
+    }
+    return num_bytes;
+}
+
+auto CraftWorldGameState::from_snapshot(const uint8_t *data, std::size_t size) -> CraftWorldGameState {
+    return from_snapshot(data, size, LevelRegistry::instance());
+}
+
+auto CraftWorldGameState::from_snapshot(const uint8_t *data, std::size_t size, const LevelRegistry &registry)
+    -> CraftWorldGameState {
+    SnapshotHeader header;
+    if (size < sizeof(header)) {
+        throw std::invalid_argument("Snapshot is too small.");
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != kSnapshotMagic) {
+        throw std::invalid_argument("Invalid snapshot header.");
+    }
+    const std::size_t board_size = static_cast<std::size_t>(header.rows) * header.cols;
+    const bool is_delta = header.grid_encoding == SnapshotGridEncoding::kDelta;
+    const bool valid_grid_size = is_delta ? header.grid_size % kDeltaEntrySize == 0
+                                          : header.grid_encoding == SnapshotGridEncoding::kRaw &&
+                                                header.grid_size == board_size;
+    if (!valid_grid_size || size < sizeof(header) + header.grid_size || header.agent_idx >= board_size) {
+        throw std::invalid_argument("Snapshot size does not match its board dimensions.");
+    }
+    if (header.goal < kPrimitiveStart || header.goal >= (kNumPrimitive + kNumRecipeTypes + kPrimitiveStart)) {
+        throw std::invalid_argument("Unknown goal element.");
+    }
+    if (!has_valid_inventory(header)) {
+        throw std::invalid_argument("Invalid inventory element in snapshot.");
+    }
+    auto shared_state = registry.find(header.level_id);
+    if (!shared_state) {
+        throw std::invalid_argument("Snapshot references a level which is not registered.");
+    }
+
+    // State starts from the level's initial board, which the delta encoding is relative to
+    CraftWorldGameState state(std::move(shared_state));
+    if (state.board.rows != header.rows || state.board.cols != header.cols) {
+        throw std::invalid_argument("Snapshot board dimensions do not match its level.");
+    }
+    const uint8_t *grid = data + sizeof(header);
+    const auto set_cell = [&](std::size_t index, uint8_t el) {
+        if (index >= board_size || el >= kNumElements) {
+            throw std::invalid_argument("Invalid board cell in snapshot.");
+        }
+        state.board.grid[index] = static_cast<Element>(el);
+    };
+    if (is_delta) {
+        for (std::size_t i = 0; i < header.grid_size; i += kDeltaEntrySize) {
+            set_cell(static_cast<std::size_t>(grid[i]) | (static_cast<std::size_t>(grid[i + 1]) << 8), grid[i + 2]);
+        }
+    } else {
         for (std::size_t i = 0; i < board_size; ++i) {
-            shared_state_ptr->zrbht_world[(channel * board_size) + i] = dist(gen);
+            set_cell(i, grid[i]);
         }
     }
-    // Zorbist hashing for inventory
-    for (std::size_t channel = 0; channel < kNumElements; ++channel) {
-        for (std::size_t i = 0; i < shared_state_ptr->MAX_INV_HASH_ITEMS; ++i) {
-            shared_state_ptr->zrbht_inventory[(channel * shared_state_ptr->MAX_INV_HASH_ITEMS) + i] = dist(gen);
+    state.board.agent_idx = header.agent_idx;
+    state.board.zorb_hash = header.zorb_hash;
+    state.local_state.reward_signal = header.reward_signal;
+    state.local_state.current_reward = header.current_reward;
+    for (std::size_t el = 0; el < kNumElements; ++el) {
+        const uint16_t count = header.inventory[el];    // NOLINT(*-constant-array-index)
+        if (count > 0) {
+            state.local_state.inventory[static_cast<Element>(el)] = count;
         }
     }
+    return state;
 }
 
 void CraftWorldGameState::reset() {
     // Board, local, and shared state info
-    board = util::parse_board_str(shared_state_ptr->game_board_str);
+    board = shared_state_ptr->initial_board;
     local_state = LocalState();
-
-    InitZrbhtTable();
-
-    // Set initial hash for game world
-    const std::size_t board_size = board.rows * board.cols;
-    for (std::size_t i = 0; i < board_size; ++i) {
-        board.zorb_hash ^= shared_state_ptr->zrbht_world.at((static_cast<std::size_t>(board.item(i)) * board_size) + i);
-    }
 }
 
 void CraftWorldGameState::RemoveItemFromBoard(std::size_t index) noexcept {
     const Element el = board.item(index);
     const std::size_t board_size = board.rows * board.cols;
-    board.zorb_hash ^= shared_state_ptr->zrbht_world.at((static_cast<std::size_t>(el) * board_size) + index);
+    board.zorb_hash ^= shared_state_ptr->zrbht->world.at((static_cast<std::size_t>(el) * board_size) + index);
     board.item(index) = Element::kEmpty;
 }
 
@@ -131,29 +328,26 @@ void CraftWorldGameState::HandleAgentMovement(Action action) noexcept {
     const std::size_t agent_idx = board.agent_idx;
     const std::size_t new_idx = IndexFromAction(agent_idx, action);
     if (InBounds(agent_idx, action) && board.item(new_idx) == Element::kEmpty) {
-        board.zorb_hash ^=
-            shared_state_ptr
-                ->zrbht_world[(static_cast<std::size_t>(Element::kAgent) * board.cols * board.rows) + agent_idx];
-        board.zorb_hash ^=
-            shared_state_ptr
-                ->zrbht_world[(static_cast<std::size_t>(Element::kEmpty) * board.cols * board.rows) + new_idx];
+        const std::vector<uint64_t> &keys = shared_state_ptr->zrbht->world;
+        const std::size_t agent_channel = static_cast<std::size_t>(Element::kAgent) * board.cols * board.rows;
+        const std::size_t empty_channel = static_cast<std::size_t>(Element::kEmpty) * board.cols * board.rows;
+        board.zorb_hash ^= keys.at(agent_channel + agent_idx);
+        board.zorb_hash ^= keys.at(empty_channel + new_idx);
         board.item(new_idx) = Element::kAgent;
         board.item(agent_idx) = Element::kEmpty;
         board.agent_idx = new_idx;
-        board.zorb_hash ^=
-            shared_state_ptr
-                ->zrbht_world[(static_cast<std::size_t>(Element::kAgent) * board.cols * board.rows) + new_idx];
-        board.zorb_hash ^=
-            shared_state_ptr
-                ->zrbht_world[(static_cast<std::size_t>(Element::kEmpty) * board.cols * board.rows) + agent_idx];
+        board.zorb_hash ^= keys.at(agent_channel + new_idx);
+        board.zorb_hash ^= keys.at(empty_channel + agent_idx);
     }
 }
 
 void CraftWorldGameState::HandleAgentUse() noexcept {
     const std::size_t agent_idx = board.agent_idx;
     // Check all neighbours (we don't have directional look)
-    SetNeighbours(agent_idx);
-    for (auto const &neighbour_idx : shared_state_ptr->neighbours) {
+    std::array<std::size_t, kNumActions> neighbours{};
+    const std::size_t num_neighbours = GetNeighbours(agent_idx, neighbours);
+    for (std::size_t n = 0; n < num_neighbours; ++n) {
+        const std::size_t neighbour_idx = neighbours[n];    // NOLINT(*-constant-array-index)
         // Nothing on this index to do something
         if (board.item(neighbour_idx) == Element::kEmpty) {
             continue;
@@ -250,121 +444,128 @@ void CraftWorldGameState::legal_actions(std::vector<Action> &actions) const noex
     }
 }
 
-auto CraftWorldGameState::observation_shape() const noexcept -> std::array<int, 3> {
+namespace {
+// Observation source over the board and inventory of a game state, see observation.h
+struct StateSource {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    const Board &board;
+    const LocalState &local_state;
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    [[nodiscard]] auto rows() const noexcept -> std::size_t {
+        return board.rows;
+    }
+    [[nodiscard]] auto cols() const noexcept -> std::size_t {
+        return board.cols;
+    }
+    [[nodiscard]] auto cell(std::size_t index) const noexcept -> Element {
+        return board.item(index);
+    }
+    [[nodiscard]] auto goal() const noexcept -> Element {
+        return board.goal;
+    }
+    template <typename F>
+    void for_each_inventory(F &&f) const {
+        for (const auto &[element, count] : local_state.inventory) {
+            f(element, count);
+        }
+    }
+};
+}    // namespace
+
+auto CraftWorldGameState::observation_shape(ObservationLayout layout) const noexcept -> std::array<int, 3> {
     // Empty doesn't get a channel, empty = all channels 0
-    return {kNumChannels, static_cast<int>(board.rows), static_cast<int>(board.cols)};
+    return make_observation_shape(kNumChannels, board.rows, board.cols, layout);
 }
 
-auto CraftWorldGameState::observation_shape_binary() const noexcept -> std::array<int, 3> {
+auto CraftWorldGameState::observation_shape_binary(ObservationLayout layout) const noexcept -> std::array<int, 3> {
     // Empty doesn't get a channel, empty = all channels 0
-    return {kNumBinaryChannels, static_cast<int>(board.rows), static_cast<int>(board.cols)};
+    return make_observation_shape(kNumBinaryChannels, board.rows, board.cols, layout);
 }
 
-auto CraftWorldGameState::observation_shape_environment() const noexcept -> std::array<int, 3> {
-    return {kNumEnvironment + kNumPrimitive, static_cast<int>(board.rows), static_cast<int>(board.cols)};
+auto CraftWorldGameState::observation_shape_environment(ObservationLayout layout) const noexcept
+    -> std::array<int, 3> {
+    return make_observation_shape(kNumEnvironment + kNumPrimitive, board.rows, board.cols, layout);
 }
 
-auto CraftWorldGameState::get_observation() const noexcept -> std::vector<float> {
+auto CraftWorldGameState::get_observation(ObservationLayout layout) const noexcept -> std::vector<float> {
     const std::size_t channel_length = board.rows * board.cols;
     std::vector<float> obs(kNumChannels * channel_length, 0);
-    get_observation(obs);
+    write_observation(obs.data(), StateSource{board, local_state}, layout);
     return obs;
 }
 
-void CraftWorldGameState::get_observation(std::vector<float> &obs) const noexcept {
+void CraftWorldGameState::get_observation(std::vector<float> &obs, ObservationLayout layout) const noexcept {
     const std::size_t channel_length = board.rows * board.cols;
-    const std::size_t obs_size = kNumChannels * channel_length;
-
-    obs.clear();
-    obs.reserve(obs_size);
-    std::fill_n(std::back_inserter(obs), obs_size, static_cast<float>(0));
-
-    // Board environment + primitives + agent
-    for (std::size_t i = 0; i < channel_length; ++i) {
-        const auto el = board.item(i);
-        if (el != Element::kEmpty) {
-            obs[static_cast<std::size_t>(el) * channel_length + i] = 1;
-        }
-    }
-    // Inventory (entire channel is filled with # of that item)
-    for (const auto &[inv_el, inv_count] : local_state.inventory) {
-        const auto channel = static_cast<std::size_t>(inv_el) + kNumPrimitive;
-        std::fill_n(obs.begin() + static_cast<int>(channel * channel_length), channel_length,
-                    static_cast<float>(inv_count));
-    }
-    // Current goal for this level (26-34)
-    const std::size_t channel = kNumChannels - kNumGoals + static_cast<std::size_t>(board.goal) - kRecipeStart;
-    std::fill_n(obs.begin() + static_cast<int>(channel * channel_length), channel_length, static_cast<float>(1));
+    obs.resize(kNumChannels * channel_length);
+    write_observation(obs.data(), StateSource{board, local_state}, layout);
 }
 
-auto CraftWorldGameState::get_binary_observation() const noexcept -> std::vector<float> {
+auto CraftWorldGameState::get_binary_observation(ObservationLayout layout) const noexcept -> std::vector<float> {
     const std::size_t channel_length = board.rows * board.cols;
-    const std::size_t obs_size = kNumBinaryChannels * channel_length;
-
-    std::vector<float> obs(obs_size, 0);
-
-    // Board environment + primitives + agent
-    for (std::size_t i = 0; i < channel_length; ++i) {
-        const auto el = board.item(i);
-        if (el != Element::kEmpty) {
-            obs[static_cast<std::size_t>(el) * channel_length + i] = 1;
-        }
-    }
-    // Inventory (entire channel is filled with maximum of 2 elements on consecutive binary channels)
-    for (const auto &[inv_el, inv_count] : local_state.inventory) {
-        auto channel = kNumPrimitive + kNumEnvironment + 2 * (static_cast<std::size_t>(inv_el) - kNumEnvironment);
-        std::fill_n(obs.begin() + static_cast<int>(channel * channel_length), channel_length, 1);
-        if (inv_count > 1) {
-            ++channel;
-            std::fill_n(obs.begin() + static_cast<int>(channel * channel_length), channel_length, 1);
-        }
-    }
-    // Current goal for this level (26-34)
-    const std::size_t channel =
-        kNumEnvironment + kNumPrimitive + (2 * kNumInventory) + (static_cast<std::size_t>(board.goal) - kRecipeStart);
-    std::fill_n(obs.begin() + static_cast<int>(channel * channel_length), channel_length, static_cast<float>(1));
-
+    std::vector<float> obs(kNumBinaryChannels * channel_length, 0);
+    write_binary_observation(obs.data(), StateSource{board, local_state}, layout);
     return obs;
 }
 
-auto CraftWorldGameState::get_observation_environment() const noexcept -> std::vector<float> {
+void CraftWorldGameState::get_binary_observation(std::vector<float> &obs, ObservationLayout layout) const noexcept {
+    const std::size_t channel_length = board.rows * board.cols;
+    obs.resize(kNumBinaryChannels * channel_length);
+    write_binary_observation(obs.data(), StateSource{board, local_state}, layout);
+}
+
+auto CraftWorldGameState::get_observation_environment(ObservationLayout layout) const noexcept -> std::vector<float> {
     const std::size_t channel_length = board.cols * board.rows;
     std::vector<float> obs((kNumEnvironment + kNumPrimitive) * channel_length, static_cast<float>(0));
-    get_observation_environment(obs);
+    write_environment_observation(obs.data(), StateSource{board, local_state}, layout);
     return obs;
 }
 
-void CraftWorldGameState::get_observation_environment(std::vector<float> &obs) const noexcept {
+void CraftWorldGameState::get_observation_environment(std::vector<float> &obs,
+                                                      ObservationLayout layout) const noexcept {
     const std::size_t channel_length = board.cols * board.rows;
-    const std::size_t obs_size = (kNumEnvironment + kNumPrimitive) * channel_length;
-    obs.clear();
-    obs.reserve(obs_size);
-    std::fill_n(std::back_inserter(obs), obs_size, static_cast<float>(0));
-
-    // Board environment + primitives + agent (0-11)
-    for (std::size_t i = 0; i < channel_length; ++i) {
-        const auto el = board.item(i);
-        if (el != Element::kEmpty) {
-            obs[static_cast<std::size_t>(el) * channel_length + i] = 1;
-        }
-    }
+    obs.resize((kNumEnvironment + kNumPrimitive) * channel_length);
+    write_environment_observation(obs.data(), StateSource{board, local_state}, layout);
 }
 
-// Spite assets
-#include "assets_all.inc"
+void CraftWorldGameState::get_observation(float *obs, ObservationLayout layout) const noexcept {
+    write_observation(obs, StateSource{board, local_state}, layout);
+}
 
-void fill_sprite(std::vector<uint8_t> &img, const std::vector<uint8_t> &sprite_data, std::size_t h, std::size_t w,
-                 std::size_t cols) {
-    const std::size_t img_idx_top_left = h * (SPRITE_DATA_LEN * cols) + (w * SPRITE_DATA_LEN_PER_ROW);
-    for (std::size_t r = 0; r < SPRITE_HEIGHT; ++r) {
-        for (std::size_t c = 0; c < SPRITE_WIDTH; ++c) {
-            const std::size_t data_idx = (r * SPRITE_DATA_LEN_PER_ROW) + (3 * c);
-            const std::size_t img_idx = (r * SPRITE_DATA_LEN_PER_ROW * cols) + (SPRITE_CHANNELS * c) + img_idx_top_left;
-            img[img_idx + 0] = sprite_data[data_idx + 0];
-            img[img_idx + 1] = sprite_data[data_idx + 1];
-            img[img_idx + 2] = sprite_data[data_idx + 2];
-        }
-    }
+void CraftWorldGameState::get_observation(Float16 *obs, ObservationLayout layout) const noexcept {
+    write_observation(obs, StateSource{board, local_state}, layout);
+}
+
+void CraftWorldGameState::get_observation(BFloat16 *obs, ObservationLayout layout) const noexcept {
+    write_observation(obs, StateSource{board, local_state}, layout);
+}
+
+void CraftWorldGameState::get_binary_observation(float *obs, ObservationLayout layout) const noexcept {
+    write_binary_observation(obs, StateSource{board, local_state}, layout);
+}
+
+void CraftWorldGameState::get_binary_observation(Float16 *obs, ObservationLayout layout) const noexcept {
+    write_binary_observation(obs, StateSource{board, local_state}, layout);
+}
+
+void CraftWorldGameState::get_binary_observation(BFloat16 *obs, ObservationLayout layout) const noexcept {
+    write_binary_observation(obs, StateSource{board, local_state}, layout);
+}
+
+void CraftWorldGameState::get_observation_environment(float *obs, ObservationLayout layout) const noexcept {
+    write_environment_observation(obs, StateSource{board, local_state}, layout);
+}
+
+void CraftWorldGameState::get_observation_environment(Float16 *obs, ObservationLayout layout) const noexcept {
+    write_environment_observation(obs, StateSource{board, local_state}, layout);
+}
+
+void CraftWorldGameState::get_observation_environment(BFloat16 *obs, ObservationLayout layout) const noexcept {
+    write_environment_observation(obs, StateSource{board, local_state}, layout);
+}
+
+auto CraftWorldGameState::observation_size(ObservationType obs_type) const noexcept -> std::size_t {
+    return observation_channels(obs_type) * board.rows * board.cols;
 }
 
 auto CraftWorldGameState::image_shape() const noexcept -> std::array<std::size_t, 3> {
@@ -373,35 +574,57 @@ auto CraftWorldGameState::image_shape() const noexcept -> std::array<std::size_t
     return {rows * SPRITE_HEIGHT, cols * SPRITE_WIDTH, SPRITE_CHANNELS};
 }
 
+auto CraftWorldGameState::image_shape(int tile_size, ImageFormat format) const -> std::array<std::size_t, 3> {
+    if (!is_valid_tile_size(tile_size)) {
+        throw std::invalid_argument("Unsupported tile size.");
+    }
+    const auto rows = board.rows + 4;
+    const auto cols = board.cols + 4;
+    const auto size = static_cast<std::size_t>(tile_size);
+    return {rows * size, cols * size, static_cast<std::size_t>(image_channels(format))};
+}
+
 auto CraftWorldGameState::to_image() const noexcept -> std::vector<uint8_t> {
+    return to_image(SPRITE_WIDTH);
+}
+
+auto CraftWorldGameState::to_image(int tile_size, ImageFormat format) const -> std::vector<uint8_t> {
+    const auto shape = image_shape(tile_size, format);
+    std::vector<uint8_t> img(shape[0] * shape[1] * shape[2]);
+    render_into(img.data(), tile_size, format);
+    return img;
+}
+
+void CraftWorldGameState::render_into(uint8_t *out, int tile_size, ImageFormat format) const {
+    const SpriteAtlas &atlas = get_sprite_atlas(tile_size, format);
+    const std::size_t sprite_len = atlas.sprite_len();
+
     // Pad board with black border
     const auto rows = board.rows + 4;
     const auto cols = board.cols + 4;
-    const auto channel_length = rows * cols;
-    std::vector<uint8_t> img(channel_length * SPRITE_DATA_LEN, 0);
+    const std::size_t tile_row_len = cols * sprite_len;
 
-    // Inner border is wall
+    // Inner border is wall, top wall row is copied wholesale to the bottom
+    atlas.clear(out, 1, 0, cols);
+    atlas.clear(out, 1, cols - 1, cols);
     for (std::size_t w = 1; w < cols - 1; ++w) {
-        fill_sprite(img, img_asset_map.at(Element::kWall), 1, w, cols);
-        fill_sprite(img, img_asset_map.at(Element::kWall), rows - 2, w, cols);
+        atlas.blit(out, Element::kWall, 1, w, cols);
     }
-    for (std::size_t h = 1; h < rows - 1; ++h) {
-        fill_sprite(img, img_asset_map.at(Element::kWall), h, 1, cols);
-        fill_sprite(img, img_asset_map.at(Element::kWall), h, cols - 2, cols);
+    std::memcpy(out + ((rows - 2) * tile_row_len), out + tile_row_len, tile_row_len);
+    for (std::size_t h = 2; h < rows - 2; ++h) {
+        atlas.clear(out, h, 0, cols);
+        atlas.blit(out, Element::kWall, h, 1, cols);
+        atlas.blit(out, Element::kWall, h, cols - 2, cols);
+        atlas.clear(out, h, cols - 1, cols);
     }
 
     // Outer border is inventory
-    std::vector<std::pair<std::size_t, std::size_t>> indices;
-    for (std::size_t w = 0; w < cols; ++w) {
-        indices.emplace_back(0, w);
-    }
-    for (std::size_t w = 0; w < cols; ++w) {
-        indices.emplace_back(rows - 1, w);
-    }
+    std::memset(out, 0, tile_row_len);
+    std::memset(out + ((rows - 1) * tile_row_len), 0, tile_row_len);
     std::size_t inv_idx = 0;
     for (const auto &[inv_item, inv_count] : local_state.inventory) {
-        for (std::size_t i = 0; i < inv_count; ++i) {
-            fill_sprite(img, img_asset_map.at(inv_item), indices[inv_idx].first, indices[inv_idx].second, cols);
+        for (std::size_t i = 0; i < inv_count && inv_idx < 2 * cols; ++i) {
+            atlas.blit(out, inv_item, inv_idx < cols ? 0 : rows - 1, inv_idx % cols, cols);
             ++inv_idx;
         }
     }
@@ -410,12 +633,10 @@ auto CraftWorldGameState::to_image() const noexcept -> std::vector<uint8_t> {
     std::size_t board_idx = 0;
     for (std::size_t h = 2; h < rows - 2; ++h) {
         for (std::size_t w = 2; w < cols - 2; ++w) {
-            const auto el = board.item(board_idx);
-            fill_sprite(img, img_asset_map.at(el), h, w, cols);
+            atlas.blit(out, board.item(board_idx), h, w, cols);
             ++board_idx;
         }
     }
-    return img;
 }
 
 auto CraftWorldGameState::get_reward_signal() const noexcept -> uint64_t {
@@ -463,29 +684,45 @@ auto CraftWorldGameState::subgoal_to_str(Subgoal subgoal) const noexcept -> std:
     return kSubgoalToStr.at(subgoal);
 }
 
-std::ostream &operator<<(std::ostream &os, const CraftWorldGameState &state) {
-    for (std::size_t w = 0; w < state.board.cols + 2; ++w) {
-        os << "-";
-    }
-    os << std::endl;
-    for (std::size_t h = 0; h < state.board.rows; ++h) {
-        os << "|";
-        for (std::size_t w = 0; w < state.board.cols; ++w) {
-            const std::size_t idx = h * state.board.cols + w;
-            os << kElementToSymbolMap.at(state.board.item(idx));
+void CraftWorldGameState::to_string_into(std::string &out) const {
+    // Board with border, goal line, and inventory line with up to kNumElements items
+    constexpr std::size_t kMaxLineLen = 64;
+    const std::size_t row_len = board.cols + 3;
+    out.clear();
+    out.reserve(((board.rows + 2) * row_len) + kMaxLineLen + (kNumElements * kMaxLineLen));
+
+    out.append(board.cols + 2, '-');
+    out.push_back('\n');
+    for (std::size_t h = 0; h < board.rows; ++h) {
+        out.push_back('|');
+        for (std::size_t w = 0; w < board.cols; ++w) {
+            out.push_back(kElementSymbols[static_cast<std::size_t>(board.item((h * board.cols) + w))]);
         }
-        os << "|" << std::endl;
-    }
-    for (std::size_t w = 0; w < state.board.cols + 2; ++w) {
-        os << "-";
+        out.append("|\n");
     }
-    os << std::endl;
-    os << "Goal: " << kElementToNameMap.at(state.board.goal) << std::endl;
-    os << "Inventory: ";
-    for (const auto &[inv_item, inv_count] : state.local_state.inventory) {
-        os << "(" << kElementToNameMap.at(inv_item) << ", " << inv_count << ") ";
+    out.append(board.cols + 2, '-');
+    out.push_back('\n');
+
+    out.append("Goal: ");
+    out.append(kElementNames[static_cast<std::size_t>(board.goal)]);
+    out.push_back('\n');
+    out.append("Inventory: ");
+    std::array<char, 24> count_buf{};
+    for (const auto &[inv_item, inv_count] : local_state.inventory) {
+        out.push_back('(');
+        out.append(kElementNames[static_cast<std::size_t>(inv_item)]);
+        out.append(", ");
+        const auto result = std::to_chars(count_buf.data(), count_buf.data() + count_buf.size(), inv_count);
+        out.append(count_buf.data(), result.ptr);
+        out.append(") ");
     }
-    return os;
+}
+
+std::ostream &operator<<(std::ostream &os, const CraftWorldGameState &state) {
+    // Format into a reused buffer and hand it to the stream in one write
+    thread_local std::string buffer;
+    state.to_string_into(buffer);
+    return os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 }
 
 // ---------------------------------------------------------------------------
@@ -516,13 +753,15 @@ auto CraftWorldGameState::InBounds(std::size_t index, Action action) const noexc
     return col >= 0 && col < static_cast<int>(board.cols) && row >= 0 && row < static_cast<int>(board.rows);
 }
 
-void CraftWorldGameState::SetNeighbours(std::size_t index) const noexcept {
-    shared_state_ptr->neighbours.clear();
+auto CraftWorldGameState::GetNeighbours(std::size_t index, std::array<std::size_t, kNumActions> &neighbours) const
+    noexcept -> std::size_t {
+    std::size_t num_neighbours = 0;
     for (auto const &action : ALL_ACTIONS) {
         if (InBounds(index, action)) {
-            shared_state_ptr->neighbours.push_back(IndexFromAction(index, action));
+            neighbours[num_neighbours++] = IndexFromAction(index, action);    // NOLINT(*-constant-array-index)
         }
     }
+    return num_neighbours;
 }
 
 auto CraftWorldGameState::IsWorkShop(std::size_t index) const noexcept -> bool {
@@ -548,7 +787,7 @@ void CraftWorldGameState::RemoveFromInventory(Element element, std::size_t count
     assert(local_state.inventory.find(element) != local_state.inventory.end());
     assert(local_state.inventory[element] >= count);
     for (std::size_t i = 0; i < count; ++i) {
-        board.zorb_hash ^= shared_state_ptr->zrbht_inventory.at(
+        board.zorb_hash ^= shared_state_ptr->zrbht->inventory.at(
             (static_cast<std::size_t>(element) * shared_state_ptr->MAX_INV_HASH_ITEMS) +
             local_state.inventory[element]);
         --local_state.inventory[element];
@@ -562,7 +801,7 @@ void CraftWorldGameState::AddToInventory(Element element, std::size_t count) noe
     // Increment item `count` times and change game state hash
     for (std::size_t i = 0; i < count; ++i) {
         ++local_state.inventory[element];
-        board.zorb_hash ^= shared_state_ptr->zrbht_inventory.at(
+        board.zorb_hash ^= shared_state_ptr->zrbht->inventory.at(
             (static_cast<std::size_t>(element) * shared_state_ptr->MAX_INV_HASH_ITEMS) +
             local_state.inventory[element]);
     }
@@ -579,4 +818,42 @@ auto CraftWorldGameState::CanCraftItem(RecipeItem recipe_item) const noexcept ->
 
 // ---------------------------------------------------------------------------
 
+namespace {
+template <typename T>
+void write_observation_batch(const std::vector<CraftWorldGameState> &states, T *obs, ObservationType obs_type,
+                             ObservationLayout layout) noexcept {
+    for (const auto &state : states) {
+        switch (obs_type) {
+            case ObservationType::kFull:
+                state.get_observation(obs, layout);
+                break;
+            case ObservationType::kBinary:
+                state.get_binary_observation(obs, layout);
+                break;
+            case ObservationType::kEnvironment:
+                state.get_observation_environment(obs, layout);
+                break;
+        }
+        obs += state.observation_size(obs_type);
+    }
+}
+}    // namespace
+
+void get_observation_batch(const std::vector<CraftWorldGameState> &states, float *obs, ObservationType obs_type,
+                           ObservationLayout layout) noexcept {
+    write_observation_batch(states, obs, obs_type, layout);
+}
+
+void get_observation_batch(const std::vector<CraftWorldGameState> &states, Float16 *obs, ObservationType obs_type,
+                           ObservationLayout layout) noexcept {
+    write_observation_batch(states, obs, obs_type, layout);
+}
+
+void get_observation_batch(const std::vector<CraftWorldGameState> &states, BFloat16 *obs, ObservationType obs_type,
+                           ObservationLayout layout) noexcept {
+    write_observation_batch(states, obs, obs_type, layout);
+}
+
+// ---------------------------------------------------------------------------
+
 }    // namespace craftworld
@@ -10,6 +10,8 @@
 #include <variant>
 
 #include "definitions.h"
+#include "half.h"
+#include "snapshot.h"
 
 namespace craftworld {
 
@@ -20,6 +22,33 @@ constexpr int SPRITE_CHANNELS = 3;
 constexpr int SPRITE_DATA_LEN_PER_ROW = SPRITE_WIDTH * SPRITE_CHANNELS;
 constexpr int SPRITE_DATA_LEN = SPRITE_WIDTH * SPRITE_HEIGHT * SPRITE_CHANNELS;
 
+// Tile sizes images can be rendered at, smaller tiles are downsampled from the full size sprites
+constexpr std::array<int, 3> kSupportedTileSizes{8, 16, SPRITE_WIDTH};
+constexpr auto is_valid_tile_size(int tile_size) noexcept -> bool {
+    return tile_size == kSupportedTileSizes[0] || tile_size == kSupportedTileSizes[1] ||
+           tile_size == kSupportedTileSizes[2];
+}
+
+// Pixel format of rendered images
+enum class ImageFormat {
+    kRGB = 0,          // 3 bytes per pixel
+    kPalette = 1,      // 1 byte per pixel, index into get_image_palette()
+    kGrayscale = 2,    // 1 byte per pixel, BT.601 luma
+};
+constexpr auto image_channels(ImageFormat format) noexcept -> int {
+    return format == ImageFormat::kRGB ? SPRITE_CHANNELS : 1;
+}
+
+// Number of entries in the palette used by ImageFormat::kPalette
+constexpr std::size_t kPaletteSize = 256;
+
+/**
+ * Get the palette for images rendered with ImageFormat::kPalette.
+ * The palette is quantized from the sprite assets, with index 0 reserved for black.
+ * @return kPaletteSize RGB triplets
+ */
+auto get_image_palette() -> const std::vector<uint8_t> &;
+
 // Game parameter can be boolean, integral or floating point
 using GameParameter = std::variant<bool, int, float, std::string>;
 using GameParameters = std::unordered_map<std::string, GameParameter>;
@@ -37,19 +66,49 @@ static const GameParameters kDefaultGameParams{
     {"workshop_swap", GameParameter(false)},                               // Game board string
 };
 
+// Zobrist hashing keys, which only depend on the board size so are shared by all levels of the same size
+struct ZobristTable {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::vector<uint64_t> world;        // Key for each (element, board index)
+    std::vector<uint64_t> inventory;    // Key for each (element, inventory count)
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+/**
+ * Get the Zobrist hashing keys for the given board size, which are generated once and then cached.
+ * @param board_size Number of cells on the board
+ * @param max_inventory_items Number of inventory counts per element which have a key
+ * @return shared key table
+ */
+auto get_zobrist_table(std::size_t board_size, std::size_t max_inventory_items) -> std::shared_ptr<const ZobristTable>;
+
 // Shared global state information relevant to all states for the given game
+// Once constructed the information is read-only, so it can be shared between states on different threads
 struct SharedStateInfo {
     SharedStateInfo() = default;
-    SharedStateInfo(GameParameters params)
-        : game_board_str(std::get<std::string>(params.at("game_board_str"))),
-          workshop_swap(std::get<bool>(params.at("workshop_swap"))) {}
+    SharedStateInfo(const GameParameters &params);
+    SharedStateInfo(std::string board_str, bool workshop_swap_);
+
+    /**
+     * Construct from an already parsed board, such as from a binary levelset, without parsing or hashing it again.
+     * @param board_str Board string of the level
+     * @param workshop_swap_ Whether the workshops are swapped
+     * @param board Parsed board_str, including its initial hash
+     */
+    SharedStateInfo(std::string board_str, bool workshop_swap_, Board board);
+
+    /**
+     * Parse the starting board, and set the level id and Zobrist hashing table from the board string.
+     */
+    void init();
+
     // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
     std::string game_board_str;                                   // String representation of the starting state
-    std::unordered_map<std::size_t, uint64_t> zrbht_world;        // Zobrist hashing table
-    std::unordered_map<std::size_t, uint64_t> zrbht_inventory;    // Zobrist hashing table for inventory
-    std::vector<std::size_t> neighbours;                          // Reusable buffer for finding neighbours
-    std::size_t MAX_INV_HASH_ITEMS = 20;                          // NOLINT
-    bool workshop_swap = false;                                   // NOLINT
+    std::shared_ptr<const ZobristTable> zrbht;    // Zobrist hashing table
+    Board initial_board;                          // Parsed starting board, including its hash
+    uint64_t level_id = 0;                        // Id of the level, see util::level_id()
+    std::size_t MAX_INV_HASH_ITEMS = 20;          // NOLINT
+    bool workshop_swap = false;                   // NOLINT
     // NOLINTEND(misc-non-private-member-variables-in-classes)
     NOP_STRUCTURE(SharedStateInfo, game_board_str, MAX_INV_HASH_ITEMS, workshop_swap);
 };
@@ -67,17 +126,38 @@ struct LocalState {
     NOP_STRUCTURE(LocalState, current_reward, reward_signal, inventory);
 };
 
+class LevelRegistry;
+
 // Game state
 class CraftWorldGameState {
 public:
+    /**
+     * Construct the starting state of the level given by the game parameters.
+     * The level is interned in the global LevelRegistry, so all states of the same level share one SharedStateInfo.
+     * @param params Game parameters holding the level
+     */
     CraftWorldGameState(const GameParameters &params = kDefaultGameParams);
 
+    /**
+     * Construct the starting state of a level which is already loaded, i.e. from a LevelRegistry.
+     * @param shared_state Shared level information
+     */
+    CraftWorldGameState(std::shared_ptr<const SharedStateInfo> shared_state);
+
     /**
      * Construct from byte serialization.
      * @note this is not safe, only for internal use.
      */
     CraftWorldGameState(const std::vector<uint8_t> &byte_data);
 
+    /**
+     * Construct from byte serialization held in caller owned memory.
+     * @note this is not safe, only for internal use.
+     * @param data Pointer to the serialized bytes
+     * @param size Number of serialized bytes
+     */
+    CraftWorldGameState(const uint8_t *data, std::size_t size);
+
     auto operator==(const CraftWorldGameState &other) const noexcept -> bool;
     auto operator!=(const CraftWorldGameState &other) const noexcept -> bool;
 
@@ -92,6 +172,92 @@ public:
      */
     [[nodiscard]] auto serialize() const -> std::vector<uint8_t>;
 
+    /**
+     * Get the number of bytes serialize() produces for the current state.
+     * @return serialized size in bytes
+     */
+    [[nodiscard]] auto serialized_size() const noexcept -> std::size_t;
+
+    /**
+     * Serialize the state into the given vector, resizing it to the serialized size.
+     * @note Use when wanting to reuse a pre-allocated vector
+     * @param byte_data Vector to store the serialization in
+     */
+    void serialize_into(std::vector<uint8_t> &byte_data) const;
+
+    /**
+     * Serialize the state into caller owned memory.
+     * @param out Buffer to store the serialization in
+     * @param size Size of the buffer in bytes, at least serialized_size()
+     * @return number of bytes written
+     */
+    auto serialize_into(uint8_t *out, std::size_t size) const -> std::size_t;
+
+    /**
+     * Get the id of the level this state belongs to.
+     * @return level id
+     */
+    [[nodiscard]] auto level_id() const noexcept -> uint64_t;
+
+    /**
+     * Get the shared information of the level this state belongs to.
+     * @return shared level information
+     */
+    [[nodiscard]] auto shared_state() const noexcept -> const std::shared_ptr<const SharedStateInfo> &;
+
+    /**
+     * Get the number of bytes snapshot() produces for the current state.
+     * @param encoding How the board grid is stored
+     * @return snapshot size in bytes
+     */
+    [[nodiscard]] auto snapshot_size(SnapshotGridEncoding encoding = SnapshotGridEncoding::kRaw) const noexcept
+        -> std::size_t;
+
+    /**
+     * Get a compact snapshot of the state, see SnapshotHeader.
+     * Unlike serialize() the level itself is not stored, only its level id.
+     * @param encoding How the board grid is stored, kDelta only stores the cells changed since the start of the level
+     * @return bytes representing the state
+     * @throw std::invalid_argument if the board or an inventory count is too large for the snapshot encoding
+     */
+    [[nodiscard]] auto snapshot(SnapshotGridEncoding encoding = SnapshotGridEncoding::kRaw) const
+        -> std::vector<uint8_t>;
+
+    /**
+     * Write a compact snapshot of the state into caller owned memory.
+     * @param out Buffer to store the snapshot in
+     * @param size Size of the buffer in bytes, at least snapshot_size(encoding)
+     * @param encoding How the board grid is stored
+     * @return number of bytes written
+     * @throw std::invalid_argument if the buffer is too small, or the board or an inventory count is too large for the
+     *        snapshot encoding
+     */
+    auto snapshot_into(uint8_t *out, std::size_t size, SnapshotGridEncoding encoding = SnapshotGridEncoding::kRaw) const
+        -> std::size_t;
+
+    /**
+     * Construct a state from a snapshot, resolving its level through the global LevelRegistry.
+     * @note The registry holds levels weakly, so the level must be kept alive by a state, levelset, archive, trajectory
+     *       replayer or LevelRegistry::pin() when the snapshot is loaded
+     * @param data Pointer to the snapshot bytes
+     * @param size Number of snapshot bytes
+     * @return state
+     * @throw std::invalid_argument if the snapshot is malformed or its level is not registered
+     */
+    [[nodiscard]] static auto from_snapshot(const uint8_t *data, std::size_t size) -> CraftWorldGameState;
+
+    /**
+     * Construct a state from a snapshot, resolving its level through the given registry.
+     * @note The level must be alive when the snapshot is loaded, see from_snapshot(const uint8_t *, std::size_t)
+     * @param data Pointer to the snapshot bytes
+     * @param size Number of snapshot bytes
+     * @param registry Registry holding the level of the snapshot
+     * @return state
+     * @throw std::invalid_argument if the snapshot is malformed or its level is not registered
+     */
+    [[nodiscard]] static auto from_snapshot(const uint8_t *data, std::size_t size, const LevelRegistry &registry)
+        -> CraftWorldGameState;
+
     /**
      * Check if the given element is valid.
      * @param element Element to check
@@ -137,61 +303,165 @@ public:
 
     /**
      * Get the shape the observations should be viewed as.
-     * @return vector indicating observation CHW
+     * @param layout Memory layout of the observation
+     * @return array indicating observation shape in the given layout (CHW or HWC)
      */
-    [[nodiscard]] auto observation_shape() const noexcept -> std::array<int, 3>;
+    [[nodiscard]] auto observation_shape(ObservationLayout layout = ObservationLayout::kCHW) const noexcept
+        -> std::array<int, 3>;
 
     /**
      * Get the shape the observations should be viewed as for the binary observation.
-     * @return vector indicating observation CHW
+     * @param layout Memory layout of the observation
+     * @return array indicating observation shape in the given layout (CHW or HWC)
      */
-    [[nodiscard]] auto observation_shape_binary() const noexcept -> std::array<int, 3>;
+    [[nodiscard]] auto observation_shape_binary(ObservationLayout layout = ObservationLayout::kCHW) const noexcept
+        -> std::array<int, 3>;
 
     /**
-     * Get the shape the observations should be viewed as.
-     * @return vector indicating observation CHW
+     * Get the shape the observations should be viewed as for the environment observation.
+     * @param layout Memory layout of the observation
+     * @return array indicating observation shape in the given layout (CHW or HWC)
      */
-    [[nodiscard]] auto observation_shape_environment() const noexcept -> std::array<int, 3>;
+    [[nodiscard]] auto observation_shape_environment(ObservationLayout layout = ObservationLayout::kCHW) const noexcept
+        -> std::array<int, 3>;
 
     /**
      * Get a flat representation of the current state observation.
-     * The observation should be viewed as the shape given by observation_shape().
+     * The observation should be viewed as the shape given by observation_shape(layout).
+     * @param layout Memory layout of the observation
      * @return vector where 1 represents element at position
      */
-    [[nodiscard]] auto get_observation() const noexcept -> std::vector<float>;
+    [[nodiscard]] auto get_observation(ObservationLayout layout = ObservationLayout::kCHW) const noexcept
+        -> std::vector<float>;
 
     /**
      * Get a flat representation of the current state observation in binary format.
-     * The observation should be viewed as the shape given by observation_shape().
+     * The observation should be viewed as the shape given by observation_shape_binary(layout).
+     * @param layout Memory layout of the observation
      * @return vector where 1 represents element at position
      */
-    [[nodiscard]] auto get_binary_observation() const noexcept -> std::vector<float>;
+    [[nodiscard]] auto get_binary_observation(ObservationLayout layout = ObservationLayout::kCHW) const noexcept
+        -> std::vector<float>;
+
+    /**
+     * Get a flat representation of the current state observation in binary format, and store in the given vector.
+     * @note Use when wanting to reuse a pre-allocated vector
+     * The observation should be viewed as the shape given by observation_shape_binary(layout).
+     * @param obs Vector to store the observation in
+     * @param layout Memory layout of the observation
+     */
+    void get_binary_observation(std::vector<float> &obs,
+                                ObservationLayout layout = ObservationLayout::kCHW) const noexcept;
 
     /**
      * Get a flat representation of the current state observation, and store in the given vector.
      * @note Use when wanting to reuse a pre-allocated vector
-     * The observation should be viewed as the shape given by observation_shape(), where 1 represents the element at the
-     * given position.
+     * The observation should be viewed as the shape given by observation_shape(layout), where 1 represents the element
+     * at the given position.
      * @param obs Vector to store the observation in
+     * @param layout Memory layout of the observation
      */
-    void get_observation(std::vector<float> &obs) const noexcept;
+    void get_observation(std::vector<float> &obs, ObservationLayout layout = ObservationLayout::kCHW) const noexcept;
 
     /**
      * Get a flat representation of the current state observation without the goal or inventory
-     * The observation should be viewed as the shape given by observation_shape().
+     * The observation should be viewed as the shape given by observation_shape_environment(layout).
+     * @param layout Memory layout of the observation
      * @return vector where 1 represents element at position
      */
-    [[nodiscard]] auto get_observation_environment() const noexcept -> std::vector<float>;
+    [[nodiscard]] auto get_observation_environment(ObservationLayout layout = ObservationLayout::kCHW) const noexcept
+        -> std::vector<float>;
 
     /**
      * Get a flat representation of the current state observation without the goal or inventory, and store in the given
      * vector.
      * @note Use when wanting to reuse a pre-allocated vector
-     * The observation should be viewed as the shape given by observation_shape(), where 1 represents the element at the
-     * given position.
+     * The observation should be viewed as the shape given by observation_shape_environment(layout), where 1 represents
+     * the element at the given position.
      * @param obs Vector to store the observation in
+     * @param layout Memory layout of the observation
+     */
+    void get_observation_environment(std::vector<float> &obs,
+                                     ObservationLayout layout = ObservationLayout::kCHW) const noexcept;
+
+    /**
+     * Write a flat representation of the current state observation into the given buffer.
+     * @note The buffer must hold at least the number of elements given by observation_shape(layout)
+     * @param obs Buffer to store the observation in
+     * @param layout Memory layout of the observation
+     */
+    void get_observation(float *obs, ObservationLayout layout = ObservationLayout::kCHW) const noexcept;
+
+    /**
+     * Write a flat representation of the current state observation in binary format into the given buffer.
+     * @note The buffer must hold at least the number of elements given by observation_shape_binary(layout)
+     * @param obs Buffer to store the observation in
+     * @param layout Memory layout of the observation
+     */
+    void get_binary_observation(float *obs, ObservationLayout layout = ObservationLayout::kCHW) const noexcept;
+
+    /**
+     * Write a flat representation of the current state observation without the goal or inventory into the given
+     * buffer.
+     * @note The buffer must hold at least the number of elements given by observation_shape_environment(layout)
+     * @param obs Buffer to store the observation in
+     * @param layout Memory layout of the observation
+     */
+    void get_observation_environment(float *obs, ObservationLayout layout = ObservationLayout::kCHW) const noexcept;
+
+    /**
+     * Write the observation of get_observation() in half precision into the given buffer.
+     * @note Observation values are small integers, so the conversion is exact
+     * @param obs Buffer holding at least the number of elements given by observation_shape(layout)
+     * @param layout Memory layout of the observation
+     */
+    void get_observation(Float16 *obs, ObservationLayout layout = ObservationLayout::kCHW) const noexcept;
+
+    /**
+     * Write the observation of get_observation() in bfloat16 into the given buffer.
+     * @note Observation values are small integers, so the conversion is exact
+     * @param obs Buffer holding at least the number of elements given by observation_shape(layout)
+     * @param layout Memory layout of the observation
+     */
+    void get_observation(BFloat16 *obs, ObservationLayout layout = ObservationLayout::kCHW) const noexcept;
+
+    /**
+     * Write the observation of get_binary_observation() in half precision into the given buffer.
+     * @param obs Buffer holding at least the number of elements given by observation_shape_binary(layout)
+     * @param layout Memory layout of the observation
      */
-    void get_observation_environment(std::vector<float> &obs) const noexcept;
+    void get_binary_observation(Float16 *obs, ObservationLayout layout = ObservationLayout::kCHW) const noexcept;
+
+    /**
+     * Write the observation of get_binary_observation() in bfloat16 into the given buffer.
+     * @param obs Buffer holding at least the number of elements given by observation_shape_binary(layout)
+     * @param layout Memory layout of the observation
+     */
+    void get_binary_observation(BFloat16 *obs, ObservationLayout layout = ObservationLayout::kCHW) const noexcept;
+
+    /**
+     * Write the observation of get_observation_environment() in half precision into the given buffer.
+     * @param obs Buffer holding at least the number of elements given by observation_shape_environment(layout)
+     * @param layout Memory layout of the observation
+     */
+    void get_observation_environment(Float16 *obs,
+                                     ObservationLayout layout = ObservationLayout::kCHW) const noexcept;
+
+    /**
+     * Write the observation of get_observation_environment() in bfloat16 into the given buffer.
+     * @param obs Buffer holding at least the number of elements given by observation_shape_environment(layout)
+     * @param layout Memory layout of the observation
+     */
+    void get_observation_environment(BFloat16 *obs,
+                                     ObservationLayout layout = ObservationLayout::kCHW) const noexcept;
+
+    /**
+     * Get the number of elements in a flat observation of the given type.
+     * @param obs_type Kind of observation
+     * @return number of elements
+     */
+    [[nodiscard]] auto observation_size(ObservationType obs_type = ObservationType::kFull) const noexcept
+        -> std::size_t;
 
     /**
      * Get the shape the image should be viewed as.
@@ -199,12 +469,37 @@ public:
      */
     [[nodiscard]] auto image_shape() const noexcept -> std::array<std::size_t, 3>;
 
+    /**
+     * Get the shape the image should be viewed as when rendered with the given tile size.
+     * @param tile_size Width and height of each tile, one of kSupportedTileSizes
+     * @param format Pixel format of the image
+     * @return array indicating observation HWC
+     */
+    [[nodiscard]] auto image_shape(int tile_size, ImageFormat format = ImageFormat::kRGB) const
+        -> std::array<std::size_t, 3>;
+
     /**
      * Get the flat (HWC) image representation of the current state
      * @return flattened byte vector represending RGB values (HWC)
      */
     [[nodiscard]] auto to_image() const noexcept -> std::vector<uint8_t>;
 
+    /**
+     * Get the flat (HWC) image representation of the current state rendered with the given tile size.
+     * @param tile_size Width and height of each tile, one of kSupportedTileSizes
+     * @param format Pixel format of the image
+     * @return flattened byte vector represending pixel values (HWC)
+     */
+    [[nodiscard]] auto to_image(int tile_size, ImageFormat format = ImageFormat::kRGB) const -> std::vector<uint8_t>;
+
+    /**
+     * Write the flat (HWC) image representation of the current state into the given buffer.
+     * @param out Buffer holding at least the number of bytes given by image_shape(tile_size, format)
+     * @param tile_size Width and height of each tile, one of kSupportedTileSizes
+     * @param format Pixel format of the image
+     */
+    void render_into(uint8_t *out, int tile_size = SPRITE_WIDTH, ImageFormat format = ImageFormat::kRGB) const;
+
     /**
      * Get the current reward signal as a result of the previous action taken.
      * @return bit field representing events that occured
@@ -255,15 +550,24 @@ public:
      */
     [[nodiscard]] auto subgoal_to_str(Subgoal subgoal) const noexcept -> std::string;
 
+    /**
+     * Write the text representation of the state (board, goal and inventory) into the given string.
+     * @note Use when wanting to reuse a pre-allocated string
+     * @param out String to store the text in
+     */
+    void to_string_into(std::string &out) const;
+
     // All possible actions
     static const std::vector<Action> ALL_ACTIONS;
 
     friend auto operator<<(std::ostream &os, const CraftWorldGameState &state) -> std::ostream &;
+    friend class Renderer;
 
 private:
     auto IndexFromAction(std::size_t index, Action action) const noexcept -> std::size_t;
     auto InBounds(std::size_t index, Action action) const noexcept -> bool;
-    void SetNeighbours(std::size_t index) const noexcept;
+    auto GetNeighbours(std::size_t index, std::array<std::size_t, kNumActions> &neighbours) const noexcept
+        -> std::size_t;
     auto IsWorkShop(std::size_t index) const noexcept -> bool;
     auto IsPrimitive(std::size_t index) const noexcept -> bool;
     auto IsItem(std::size_t index, Element element) const noexcept -> bool;
@@ -274,13 +578,29 @@ private:
     void HandleAgentMovement(Action action) noexcept;
     void HandleAgentUse() noexcept;
     void RemoveItemFromBoard(std::size_t index) noexcept;
-    void InitZrbhtTable() noexcept;
 
-    std::shared_ptr<SharedStateInfo> shared_state_ptr;
+    std::shared_ptr<const SharedStateInfo> shared_state_ptr;
     Board board;
     LocalState local_state;
 };
 
+/**
+ * Write the observations of a batch of states into a single buffer, one observation after another.
+ * @param states States to observe
+ * @param obs Buffer holding the sum of observation_size(obs_type) over all states
+ * @param obs_type Kind of observation
+ * @param layout Memory layout of each observation
+ */
+void get_observation_batch(const std::vector<CraftWorldGameState> &states, float *obs,
+                           ObservationType obs_type = ObservationType::kFull,
+                           ObservationLayout layout = ObservationLayout::kCHW) noexcept;
+void get_observation_batch(const std::vector<CraftWorldGameState> &states, Float16 *obs,
+                           ObservationType obs_type = ObservationType::kFull,
+                           ObservationLayout layout = ObservationLayout::kCHW) noexcept;
+void get_observation_batch(const std::vector<CraftWorldGameState> &states, BFloat16 *obs,
+                           ObservationType obs_type = ObservationType::kFull,
+                           ObservationLayout layout = ObservationLayout::kCHW) noexcept;
+
 }    // namespace craftworld
 
 #endif    // CRAFTWORLD_BASE_H_
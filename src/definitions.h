@@ -7,6 +7,7 @@
 #include <cassert>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -130,6 +131,19 @@ constexpr std::size_t kNumGoals = kNumRecipeTypes;
 constexpr std::size_t kNumChannels = kNumEnvironment + kNumPrimitive + kNumInventory + kNumGoals;
 constexpr std::size_t kNumBinaryChannels = kNumEnvironment + kNumPrimitive + (2 * kNumInventory) + kNumGoals;
 
+// Memory layout of the flat observation tensors
+enum class ObservationLayout {
+    kCHW = 0,    // Channel first
+    kHWC = 1,    // Channel last
+};
+
+// Kind of observation to produce
+enum class ObservationType {
+    kFull = 0,           // get_observation()
+    kBinary = 1,         // get_binary_observation()
+    kEnvironment = 2,    // get_observation_environment()
+};
+
 struct RecipeInputItem {
     Element element;
     int count;
@@ -279,6 +293,22 @@ const std::unordered_map<Element, std::string> kElementToNameMap{
     {Element::kGoldBar, "GoldBar"},
     {Element::kGemRing, "GemRing"},
 };
+// Symbol of each element for text rendering, indexed by element
+constexpr std::array<char, kNumElements> kElementSymbols{
+    '@', '#', '1', '2', '3', 'F', '~', 'o',                   // Env
+    'i', 'T', 'c', 'w', 'g', '.', '*',                        // Primitives
+    '?', '?', '?', '?', '?', '?', '?', '?', '?', '?', '?',    // Recipes
+    ' ',
+};
+// Name of each element for text rendering, indexed by element (empty if the element has no name)
+constexpr std::array<std::string_view, kNumElements> kElementNames{
+    "", "", "", "", "", "", "", "",                                    // Env
+    "Iron", "Tin", "Copper", "Wood", "Grass", "Gold", "Gem",           // Primitives
+    "BronzeBar", "Stick", "Plank", "Rope", "Nails", "BronzeHammer",    // Recipes
+    "BronzePick", "Bridge", "IronPick", "GoldBar", "GemRing",
+    "",
+};
+
 const std::unordered_set<Element> kWorkShops{
     Element::kWorkshop1,
     Element::kWorkshop2,
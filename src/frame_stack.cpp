@@ -0,0 +1,98 @@
+#include "frame_stack.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace craftworld {
+
+FrameStack::FrameStack(std::size_t num_frames, ObservationType obs_type, ObservationLayout layout)
+    : num_frames_(num_frames), obs_type_(obs_type), layout_(layout) {
+    if (num_frames_ == 0) {
+        throw std::invalid_argument("Number of stacked frames must be positive.");
+    }
+}
+
+void FrameStack::reset(const CraftWorldGameState &state) {
+    obs_shape_ = ObservationShape(state);
+    frame_size_ = static_cast<std::size_t>(obs_shape_[0] * obs_shape_[1] * obs_shape_[2]);
+    buffer_.resize(2 * num_frames_ * frame_size_);
+    head_ = 0;
+
+    // Every slot starts as the current observation
+    WriteFrame(state, buffer_.data());
+    for (std::size_t slot = 1; slot < 2 * num_frames_; ++slot) {
+        std::copy_n(buffer_.data(), frame_size_, buffer_.data() + (slot * frame_size_));
+    }
+}
+
+void FrameStack::push(const CraftWorldGameState &state) {
+    if (buffer_.empty()) {
+        throw std::logic_error("FrameStack::push() called before reset().");
+    }
+    if (ObservationShape(state) != obs_shape_) {
+        throw std::invalid_argument("State board dimensions differ from the state used in reset().");
+    }
+    // Newest frame replaces the oldest, and the window start advances by one slot
+    float *slot = buffer_.data() + (head_ * frame_size_);
+    WriteFrame(state, slot);
+    std::copy_n(slot, frame_size_, slot + (num_frames_ * frame_size_));
+    head_ = (head_ + 1) % num_frames_;
+}
+
+auto FrameStack::ObservationShape(const CraftWorldGameState &state) const -> std::array<int, 3> {
+    switch (obs_type_) {
+        case ObservationType::kBinary:
+            return state.observation_shape_binary(layout_);
+        case ObservationType::kEnvironment:
+            return state.observation_shape_environment(layout_);
+        case ObservationType::kFull:
+        default:
+            return state.observation_shape(layout_);
+    }
+}
+
+auto FrameStack::num_frames() const noexcept -> std::size_t {
+    return num_frames_;
+}
+
+auto FrameStack::frame_size() const noexcept -> std::size_t {
+    return frame_size_;
+}
+
+auto FrameStack::shape() const noexcept -> std::array<int, 4> {
+    return {static_cast<int>(num_frames_), obs_shape_[0], obs_shape_[1], obs_shape_[2]};
+}
+
+auto FrameStack::frame(std::size_t index) const noexcept -> const float * {
+    assert(index < num_frames_);
+    return view() + (index * frame_size_);
+}
+
+auto FrameStack::view() const noexcept -> const float * {
+    return buffer_.data() + (head_ * frame_size_);
+}
+
+void FrameStack::copy_to(float *out) const noexcept {
+    std::copy_n(view(), num_frames_ * frame_size_, out);
+}
+
+auto FrameStack::to_vector() const -> std::vector<float> {
+    return {view(), view() + (num_frames_ * frame_size_)};
+}
+
+void FrameStack::WriteFrame(const CraftWorldGameState &state, float *out) const noexcept {
+    switch (obs_type_) {
+        case ObservationType::kFull:
+            state.get_observation(out, layout_);
+            break;
+        case ObservationType::kBinary:
+            state.get_binary_observation(out, layout_);
+            break;
+        case ObservationType::kEnvironment:
+            state.get_observation_environment(out, layout_);
+            break;
+    }
+}
+
+}    // namespace craftworld
@@ -0,0 +1,100 @@
+#ifndef CRAFTWORLD_FRAME_STACK_H_
+#define CRAFTWORLD_FRAME_STACK_H_
+
+#include <array>
+#include <vector>
+
+#include "craftworld_base.h"
+#include "definitions.h"
+
+namespace craftworld {
+
+/**
+ * Stack of the last k observations of a game state.
+ * Frames are kept in a ring buffer which is mirrored, so that the stacked window is always available as a single
+ * contiguous view without moving the older frames. Each push only writes the newest frame.
+ */
+class FrameStack {
+public:
+    /**
+     * @param num_frames Number of observations to stack (k)
+     * @param obs_type Kind of observation stored in each frame
+     * @param layout Memory layout of each frame
+     */
+    FrameStack(std::size_t num_frames, ObservationType obs_type = ObservationType::kFull,
+               ObservationLayout layout = ObservationLayout::kCHW);
+
+    /**
+     * Fill every frame with the observation of the given state, i.e. at the start of an episode.
+     * @param state The state to observe
+     */
+    void reset(const CraftWorldGameState &state);
+
+    /**
+     * Push the observation of the given state as the newest frame, dropping the oldest frame.
+     * @param state The state to observe, with the same board dimensions as the state used in reset()
+     * @throw std::logic_error if reset() has not been called
+     * @throw std::invalid_argument if the board dimensions differ from the state used in reset()
+     */
+    void push(const CraftWorldGameState &state);
+
+    /**
+     * Get the number of stacked frames.
+     * @return number of frames k
+     */
+    [[nodiscard]] auto num_frames() const noexcept -> std::size_t;
+
+    /**
+     * Get the number of elements in a single frame.
+     * @return frame size
+     */
+    [[nodiscard]] auto frame_size() const noexcept -> std::size_t;
+
+    /**
+     * Get the shape the stacked observation should be viewed as.
+     * @return array indicating stacked shape (k followed by the observation shape in the given layout)
+     */
+    [[nodiscard]] auto shape() const noexcept -> std::array<int, 4>;
+
+    /**
+     * Get a frame of the stack.
+     * @param index Frame index, where 0 is the oldest and num_frames() - 1 the newest frame
+     * @return pointer to the first element of the frame
+     */
+    [[nodiscard]] auto frame(std::size_t index) const noexcept -> const float *;
+
+    /**
+     * Get a contiguous view of the stacked frames, ordered oldest to newest.
+     * @note The view is invalidated by the next call to push() or reset()
+     * @return pointer to num_frames() * frame_size() elements
+     */
+    [[nodiscard]] auto view() const noexcept -> const float *;
+
+    /**
+     * Copy the stacked frames, ordered oldest to newest, into the given buffer.
+     * @param out Buffer holding at least num_frames() * frame_size() elements
+     */
+    void copy_to(float *out) const noexcept;
+
+    /**
+     * Get a copy of the stacked frames, ordered oldest to newest.
+     * @return flat vector of the stacked observation
+     */
+    [[nodiscard]] auto to_vector() const -> std::vector<float>;
+
+private:
+    [[nodiscard]] auto ObservationShape(const CraftWorldGameState &state) const -> std::array<int, 3>;
+    void WriteFrame(const CraftWorldGameState &state, float *out) const noexcept;
+
+    std::size_t num_frames_;
+    ObservationType obs_type_;
+    ObservationLayout layout_;
+    std::array<int, 3> obs_shape_{};
+    std::size_t frame_size_ = 0;
+    std::size_t head_ = 0;         // Slot of the oldest frame
+    std::vector<float> buffer_;    // 2 * num_frames slots, slot i mirrored at i + num_frames
+};
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_FRAME_STACK_H_
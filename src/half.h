@@ -0,0 +1,127 @@
+#ifndef CRAFTWORLD_HALF_H_
+#define CRAFTWORLD_HALF_H_
+
+#include <cstdint>
+#include <cstring>
+
+namespace craftworld {
+
+// IEEE 754 half precision floating point value, stored as raw bits
+struct Float16 {
+    Float16() = default;
+    explicit Float16(float value) noexcept : bits(from_float(value)) {}
+
+    explicit operator float() const noexcept {
+        return to_float(bits);
+    }
+
+    bool operator==(const Float16 &other) const noexcept {
+        return bits == other.bits;
+    }
+
+    // Round to nearest even conversion from single precision
+    static auto from_float(float value) noexcept -> uint16_t {
+        uint32_t f = 0;
+        std::memcpy(&f, &value, sizeof(f));
+        const auto sign = static_cast<uint16_t>((f >> 16) & 0x8000U);
+        const uint32_t abs_f = f & 0x7FFFFFFFU;
+        if (abs_f >= 0x7F800000U) {
+            // Inf or NaN (keep NaN quiet)
+            return static_cast<uint16_t>(sign | 0x7C00U | (abs_f > 0x7F800000U ? 0x0200U : 0U));
+        }
+        if (abs_f >= 0x477FF000U) {
+            // Overflow to inf
+            return static_cast<uint16_t>(sign | 0x7C00U);
+        }
+        if (abs_f < 0x38800000U) {
+            // Subnormal or zero in half precision
+            if (abs_f < 0x33000000U) {
+                return sign;
+            }
+            const uint32_t exp = abs_f >> 23;
+            const uint32_t mantissa = (abs_f & 0x7FFFFFU) | 0x800000U;
+            const uint32_t shift = 126 - exp;
+            uint32_t half = mantissa >> shift;
+            const uint32_t rem = mantissa & ((1U << shift) - 1);
+            const uint32_t halfway = 1U << (shift - 1);
+            if (rem > halfway || (rem == halfway && (half & 1U) != 0)) {
+                ++half;
+            }
+            return static_cast<uint16_t>(sign | half);
+        }
+        uint32_t half = ((abs_f - 0x38000000U) >> 13);
+        const uint32_t rem = abs_f & 0x1FFFU;
+        if (rem > 0x1000U || (rem == 0x1000U && (half & 1U) != 0)) {
+            ++half;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    static auto to_float(uint16_t h) noexcept -> float {
+        const uint32_t sign = static_cast<uint32_t>(h & 0x8000U) << 16;
+        const uint32_t exp = (h >> 10) & 0x1FU;
+        uint32_t mantissa = h & 0x3FFU;
+        uint32_t f = 0;
+        if (exp == 0x1FU) {
+            f = sign | 0x7F800000U | (mantissa << 13);
+        } else if (exp != 0) {
+            f = sign | ((exp + 112) << 23) | (mantissa << 13);
+        } else if (mantissa != 0) {
+            // Normalize subnormal
+            uint32_t e = 113;
+            while ((mantissa & 0x400U) == 0) {
+                mantissa <<= 1;
+                --e;
+            }
+            f = sign | (e << 23) | ((mantissa & 0x3FFU) << 13);
+        } else {
+            f = sign;
+        }
+        float value = 0;
+        std::memcpy(&value, &f, sizeof(value));
+        return value;
+    }
+
+    uint16_t bits = 0;    // NOLINT(misc-non-private-member-variables-in-classes)
+};
+
+// Brain floating point value (upper 16 bits of single precision), stored as raw bits
+struct BFloat16 {
+    BFloat16() = default;
+    explicit BFloat16(float value) noexcept : bits(from_float(value)) {}
+
+    explicit operator float() const noexcept {
+        return to_float(bits);
+    }
+
+    bool operator==(const BFloat16 &other) const noexcept {
+        return bits == other.bits;
+    }
+
+    // Round to nearest even conversion from single precision
+    static auto from_float(float value) noexcept -> uint16_t {
+        uint32_t f = 0;
+        std::memcpy(&f, &value, sizeof(f));
+        if ((f & 0x7FFFFFFFU) > 0x7F800000U) {
+            // Keep NaN quiet instead of rounding into inf
+            return static_cast<uint16_t>((f >> 16) | 0x0040U);
+        }
+        return static_cast<uint16_t>((f + 0x7FFFU + ((f >> 16) & 1U)) >> 16);
+    }
+
+    static auto to_float(uint16_t b) noexcept -> float {
+        const uint32_t f = static_cast<uint32_t>(b) << 16;
+        float value = 0;
+        std::memcpy(&value, &f, sizeof(value));
+        return value;
+    }
+
+    uint16_t bits = 0;    // NOLINT(misc-non-private-member-variables-in-classes)
+};
+
+static_assert(sizeof(Float16) == 2, "Float16 must be 2 bytes");
+static_assert(sizeof(BFloat16) == 2, "BFloat16 must be 2 bytes");
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_HALF_H_
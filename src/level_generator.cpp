@@ -0,0 +1,242 @@
+#include "level_generator.h"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#include "definitions.h"
+#include "util.h"
+
+namespace craftworld {
+
+namespace {
+struct Ingredient {
+    Element element;
+    int count;
+};
+
+// Primitives placed for each goal, matching RECIPES in scripts/generate_levelset.py
+struct GoalRecipe {
+    Element goal;
+    std::array<Ingredient, 4> ingredients;
+};
+
+constexpr std::array<GoalRecipe, 3> kGoalRecipes{{
+    {Element::kBronzePick, {{{Element::kCopper, 1}, {Element::kTin, 1}, {Element::kWood, 1}, {Element::kEmpty, 0}}}},
+    {Element::kIronPick, {{{Element::kIron, 1}, {Element::kWood, 2}, {Element::kCopper, 1}, {Element::kTin, 1}}}},
+    {Element::kGemRing, {{{Element::kIron, 1}, {Element::kWood, 2}, {Element::kCopper, 1}, {Element::kTin, 1}}}},
+}};
+constexpr std::array<Element, 2> kExtraPrimitives{Element::kGrass, Element::kWood};
+constexpr std::array<Element, 4> kWorkshops{Element::kWorkshop1, Element::kWorkshop2, Element::kWorkshop3,
+                                            Element::kFurnace};
+
+// Minimum map size which has a cell away from the border for the treasure
+constexpr std::size_t kMinMapSize = 3;
+
+// Distributions are implemented here, as the std distributions differ between standard libraries
+auto splitmix64(uint64_t x) noexcept -> uint64_t {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;    // NOLINT(*-magic-numbers)
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;    // NOLINT(*-magic-numbers)
+    return x ^ (x >> 31);                           // NOLINT(*-magic-numbers)
+}
+
+auto uniform_index(std::mt19937_64 &rng, std::size_t n) noexcept -> std::size_t {
+    // Rejection sampling of the values below 2^64 mod n, which would bias the result
+    const uint64_t threshold = (0 - static_cast<uint64_t>(n)) % n;
+    uint64_t value = rng();
+    while (value < threshold) {
+        value = rng();
+    }
+    return static_cast<std::size_t>(value % n);
+}
+
+auto uniform_real(std::mt19937_64 &rng) noexcept -> double {
+    constexpr int kMantissaBits = 53;
+    return static_cast<double>(rng() >> (64 - kMantissaBits)) / static_cast<double>(1ULL << kMantissaBits);
+}
+
+auto sample_goal(const RecipeProbabilities &probs, std::mt19937_64 &rng) noexcept -> const GoalRecipe & {
+    const double total = std::accumulate(probs.begin(), probs.end(), 0.0);
+    const double value = uniform_real(rng) * total;
+    double cumulative = 0;
+    std::size_t last = 0;
+    for (std::size_t i = 0; i < probs.size(); ++i) {
+        if (probs[i] <= 0) {
+            continue;
+        }
+        cumulative += probs[i];
+        last = i;
+        if (value < cumulative) {
+            return kGoalRecipes[i];    // NOLINT(*-constant-array-index)
+        }
+    }
+    return kGoalRecipes[last];    // NOLINT(*-constant-array-index)
+}
+
+// Map being generated, which tracks the cells elements can still be placed on.
+// Placing an element only ever removes free cells, so each free cell is removed from an unordered list in O(1).
+class MapBuilder {
+public:
+    explicit MapBuilder(std::size_t size)
+        : size_(size), grid_(size * size, Element::kEmpty), free_(size * size), slot_(size * size) {
+        std::iota(free_.begin(), free_.end(), 0);
+        std::iota(slot_.begin(), slot_.end(), 0);
+    }
+
+    // Place an element, cells next to it and cells within 2 of a workshop are no longer free
+    void place(std::size_t index, Element element) noexcept {
+        grid_[index] = element;
+        const bool is_workshop = std::find(kWorkshops.begin(), kWorkshops.end(), element) != kWorkshops.end();
+        RemoveAround(index, is_workshop ? 2 : 1);
+    }
+
+    // Random free cell, as random_free_extra_space() in scripts/generate_levelset.py
+    auto random_free(std::mt19937_64 &rng) const -> std::size_t {
+        if (free_.empty()) {
+            throw std::invalid_argument("Map is too small to place every element.");
+        }
+        return free_[uniform_index(rng, free_.size())];
+    }
+
+    // Random cell away from the map border
+    auto random_inner(std::mt19937_64 &rng) const noexcept -> std::size_t {
+        const std::size_t row = 1 + uniform_index(rng, size_ - 2);
+        const std::size_t col = 1 + uniform_index(rng, size_ - 2);
+        return (row * size_) + col;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+        return size_;
+    }
+
+    [[nodiscard]] auto grid() const noexcept -> const std::vector<Element> & {
+        return grid_;
+    }
+
+private:
+    static constexpr std::size_t kNotFree = SIZE_MAX;
+
+    void RemoveAround(std::size_t index, std::size_t radius) noexcept {
+        const std::size_t row = index / size_;
+        const std::size_t col = index % size_;
+        const std::size_t row_end = std::min(row + radius + 1, size_);
+        const std::size_t col_end = std::min(col + radius + 1, size_);
+        for (std::size_t r = row - std::min(row, radius); r < row_end; ++r) {
+            for (std::size_t c = col - std::min(col, radius); c < col_end; ++c) {
+                Remove((r * size_) + c);
+            }
+        }
+    }
+
+    void Remove(std::size_t index) noexcept {
+        const std::size_t slot = slot_[index];
+        if (slot == kNotFree) {
+            return;
+        }
+        const std::size_t last = free_.back();
+        free_[slot] = last;
+        slot_[last] = slot;
+        free_.pop_back();
+        slot_[index] = kNotFree;
+    }
+
+    std::size_t size_;
+    std::vector<Element> grid_;
+    std::vector<std::size_t> free_;    // Cells elements can be placed on
+    std::vector<std::size_t> slot_;    // Position of each cell in free_, or kNotFree
+};
+}    // namespace
+
+void check_generator_config(const LevelGeneratorConfig &config) {
+    if (config.map_size < kMinMapSize || config.map_size > UINT16_MAX) {
+        throw std::invalid_argument("Map size must be between 3 and 65535.");
+    }
+    bool any_goal = false;
+    for (const double prob : config.recipe_probs) {
+        if (!(prob >= 0)) {
+            throw std::invalid_argument("Recipe probabilities must not be negative.");
+        }
+        any_goal = any_goal || prob > 0;
+    }
+    if (!any_goal) {
+        throw std::invalid_argument("At least one recipe probability must be positive.");
+    }
+}
+
+auto generate_level(const LevelGeneratorConfig &config, uint64_t seed) -> std::string {
+    check_generator_config(config);
+    std::mt19937_64 rng(splitmix64(seed));
+    MapBuilder map(config.map_size);
+
+    const GoalRecipe &recipe = sample_goal(config.recipe_probs, rng);
+
+    // Treasure, surrounded by water (island) or stone (cave)
+    if (recipe.goal == Element::kGoldBar || recipe.goal == Element::kGemRing) {
+        const bool is_island = recipe.goal == Element::kGoldBar;
+        const std::size_t index = map.random_inner(rng);
+        const Element wall = is_island ? Element::kWater : Element::kStone;
+        map.place(index, is_island ? Element::kGold : Element::kGem);
+        for (const std::size_t wall_index : {index - map.size(), index + map.size(), index - 1, index + 1}) {
+            map.place(wall_index, wall);
+        }
+    }
+
+    // Ingredients required for the goal
+    for (const Ingredient &ingredient : recipe.ingredients) {
+        for (int i = 0; i < ingredient.count; ++i) {
+            map.place(map.random_free(rng), ingredient.element);
+        }
+    }
+
+    // Other random ingredients to confuse
+    for (std::size_t i = 0; i < config.num_primitive; ++i) {
+        const std::size_t index = map.random_free(rng);
+        map.place(index, kExtraPrimitives[uniform_index(rng, kExtraPrimitives.size())]);    // NOLINT
+    }
+
+    // Crafting stations
+    for (const Element workshop : kWorkshops) {
+        map.place(map.random_free(rng), workshop);
+    }
+
+    // Agent
+    map.place(map.random_free(rng), Element::kAgent);
+
+    // Random grass for complexity
+    for (std::size_t i = 0; i < config.num_grass; ++i) {
+        map.place(map.random_free(rng), Element::kGrass);
+    }
+
+    Board board(config.map_size, config.map_size, recipe.goal);
+    board.grid = map.grid();
+    return util::to_board_str(board);
+}
+
+auto generate_levels(const LevelGeneratorConfig &config, uint64_t first_seed, std::size_t count, ThreadPool &pool)
+    -> std::vector<std::string> {
+    check_generator_config(config);
+    std::vector<std::string> levels(count);
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    pool.parallel_for(count, [&](std::size_t i) {
+        try {
+            levels[i] = generate_level(config, first_seed + i);
+        } catch (...) {
+            const std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return levels;
+}
+
+}    // namespace craftworld
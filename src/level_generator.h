@@ -0,0 +1,66 @@
+#ifndef CRAFTWORLD_LEVEL_GENERATOR_H_
+#define CRAFTWORLD_LEVEL_GENERATOR_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace craftworld {
+
+// Probability of each generated goal, in the order kBronzePick, kIronPick, kGemRing
+using RecipeProbabilities = std::array<double, 3>;
+
+// Goal probabilities used by scripts/generate_levelset.py
+constexpr RecipeProbabilities kRecipeProbsTrain{0.2, 0.3, 0.5};
+constexpr RecipeProbabilities kRecipeProbsHard{0.0, 0.05, 0.95};
+constexpr RecipeProbabilities kRecipeProbsTest{0.0, 0.0, 1.0};
+
+struct LevelGeneratorConfig {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::size_t map_size = 10;                               // Width and height of the map
+    std::size_t num_primitive = 0;                           // Number of extra random primitives (grass or wood)
+    std::size_t num_grass = 0;                               // Number of extra grass
+    RecipeProbabilities recipe_probs = kRecipeProbsTrain;    // Probability of each goal
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+/**
+ * Check a generator configuration. A valid config can still have a map too crowded to place every element for some
+ * seeds, which generate_level() reports.
+ * @param config Generator configuration
+ * @throw std::invalid_argument if the map size or recipe probabilities are invalid
+ */
+void check_generator_config(const LevelGeneratorConfig &config);
+
+/**
+ * Generate a level with the placement rules of scripts/generate_levelset.py:
+ *   - The gem of a kGemRing goal is placed in a stone cave, away from the map border
+ *   - The ingredients of the goal, the extra primitives, the workshops, the agent and the extra grass are then placed
+ *     one after another, each on an empty cell whose neighbours are all empty and which is at least 3 cells away
+ *     from any workshop
+ * The level only depends on the config and seed, and not on the platform or standard library.
+ * @param config Generator configuration
+ * @param seed Seed of the level
+ * @return board string, in the format written by scripts/generate_levelset.py
+ * @throw std::invalid_argument if the config is invalid, or the map is too small to place every element
+ */
+[[nodiscard]] auto generate_level(const LevelGeneratorConfig &config, uint64_t seed) -> std::string;
+
+/**
+ * Generate the levels with seeds first_seed, first_seed + 1, ... in parallel.
+ * @param config Generator configuration
+ * @param first_seed Seed of the first level
+ * @param count Number of levels to generate
+ * @param pool Threads to generate the levels on
+ * @return board string of each level, in seed order
+ * @throw std::invalid_argument if the config is invalid, or the map is too small to place every element
+ */
+[[nodiscard]] auto generate_levels(const LevelGeneratorConfig &config, uint64_t first_seed, std::size_t count,
+                                   ThreadPool &pool) -> std::vector<std::string>;
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_LEVEL_GENERATOR_H_
@@ -0,0 +1,93 @@
+#include "level_registry.h"
+
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "util.h"
+
+namespace craftworld {
+
+namespace {
+void check_same_level(const SharedStateInfo &info, const std::string &board_str, bool workshop_swap) {
+    if (info.workshop_swap != workshop_swap || info.game_board_str != board_str) {
+        throw std::invalid_argument("A different level with the same level id is already registered.");
+    }
+}
+
+// Minimum number of entries before expired levels are removed
+constexpr std::size_t kMinPruneSize = 64;
+}    // namespace
+
+auto LevelRegistry::instance() -> LevelRegistry & {
+    static LevelRegistry registry;
+    return registry;
+}
+
+auto LevelRegistry::add(const GameParameters &params) -> std::shared_ptr<const SharedStateInfo> {
+    return add(std::get<std::string>(params.at("game_board_str")), std::get<bool>(params.at("workshop_swap")));
+}
+
+auto LevelRegistry::add(const std::string &board_str, bool workshop_swap) -> std::shared_ptr<const SharedStateInfo> {
+    if (auto level = find(util::level_id(board_str, workshop_swap))) {
+        check_same_level(*level, board_str, workshop_swap);
+        return level;
+    }
+    // Build outside the lock, if another thread registered the level in the meantime we use theirs
+    return add(std::make_shared<const SharedStateInfo>(board_str, workshop_swap));
+}
+
+auto LevelRegistry::add(std::shared_ptr<const SharedStateInfo> level) -> std::shared_ptr<const SharedStateInfo> {
+    const std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto &entry = levels_[level->level_id];
+    if (auto registered = entry.lock()) {
+        check_same_level(*registered, level->game_board_str, level->workshop_swap);
+        return registered;
+    }
+    entry = level;
+    // Pruning once the map has doubled since the last prune keeps the cost amortized O(1) per added level
+    if (levels_.size() >= prune_size_) {
+        for (auto it = levels_.begin(); it != levels_.end();) {
+            it = it->second.expired() ? levels_.erase(it) : std::next(it);
+        }
+        prune_size_ = std::max(kMinPruneSize, 2 * levels_.size());
+    }
+    return level;
+}
+
+auto LevelRegistry::intern(const GameParameters &params) -> std::shared_ptr<const SharedStateInfo> {
+    return intern(std::get<std::string>(params.at("game_board_str")), std::get<bool>(params.at("workshop_swap")));
+}
+
+auto LevelRegistry::intern(const std::string &board_str, bool workshop_swap) -> std::shared_ptr<const SharedStateInfo> {
+    return add(board_str, workshop_swap);
+}
+
+auto LevelRegistry::pin(std::shared_ptr<const SharedStateInfo> level) -> std::shared_ptr<const SharedStateInfo> {
+    auto registered = add(std::move(level));
+    const std::unique_lock<std::shared_mutex> lock(mutex_);
+    pinned_[registered->level_id] = registered;
+    return registered;
+}
+
+auto LevelRegistry::unpin(uint64_t level_id) -> bool {
+    const std::unique_lock<std::shared_mutex> lock(mutex_);
+    return pinned_.erase(level_id) > 0;
+}
+
+auto LevelRegistry::find(uint64_t level_id) const -> std::shared_ptr<const SharedStateInfo> {
+    const std::shared_lock<std::shared_mutex> lock(mutex_);
+    const auto it = levels_.find(level_id);
+    return it == levels_.end() ? nullptr : it->second.lock();
+}
+
+auto LevelRegistry::size() const -> std::size_t {
+    const std::shared_lock<std::shared_mutex> lock(mutex_);
+    return static_cast<std::size_t>(std::count_if(levels_.begin(), levels_.end(),
+                                                  [](const auto &entry) { return !entry.second.expired(); }));
+}
+
+}    // namespace craftworld
@@ -0,0 +1,117 @@
+#ifndef CRAFTWORLD_LEVEL_REGISTRY_H_
+#define CRAFTWORLD_LEVEL_REGISTRY_H_
+
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include "craftworld_base.h"
+
+namespace craftworld {
+
+/**
+ * Thread-safe registry of levels, keyed by their level id.
+ * Snapshots reference levels by id, so a level must be registered before snapshots of its states can be loaded.
+ * The registry only holds weak references: a level stays registered while a state, levelset or other owner keeps it
+ * alive, and is rebuilt the next time it is added after that. Entries of expired levels are removed as the registry
+ * grows, so memory use follows the levels in use rather than every level ever seen.
+ * Levels whose snapshots must stay loadable without another owner, i.e. after their last state is gone, are kept
+ * alive by pin() until unpin().
+ */
+class LevelRegistry {
+public:
+    LevelRegistry() = default;
+    LevelRegistry(const LevelRegistry &) = delete;
+    auto operator=(const LevelRegistry &) -> LevelRegistry & = delete;
+
+    /**
+     * Get the process wide registry.
+     * @return global registry
+     */
+    static auto instance() -> LevelRegistry &;
+
+    /**
+     * Register the level given by the game parameters, or get the already registered level.
+     * @param params Game parameters holding the level
+     * @return shared level information, which states can be constructed from
+     * @throw std::invalid_argument if a different level with the same id is already registered
+     */
+    [[nodiscard]] auto add(const GameParameters &params) -> std::shared_ptr<const SharedStateInfo>;
+
+    /**
+     * Register the level given by its board string, or get the already registered level.
+     * @param board_str Board string of the level
+     * @param workshop_swap Whether the workshops are swapped
+     * @return shared level information, which states can be constructed from
+     * @throw std::invalid_argument if a different level with the same id is already registered
+     */
+    [[nodiscard]] auto add(const std::string &board_str, bool workshop_swap) -> std::shared_ptr<const SharedStateInfo>;
+
+    /**
+     * Register an already built level, or get the already registered level with the same id.
+     * @param level Shared level information
+     * @return registered level, which is either level or an equal level registered before
+     * @throw std::invalid_argument if a different level with the same id is already registered
+     */
+    [[nodiscard]] auto add(std::shared_ptr<const SharedStateInfo> level) -> std::shared_ptr<const SharedStateInfo>;
+
+    /**
+     * Get the shared level for the given game parameters, registering it if it is not registered yet.
+     * @param params Game parameters holding the level
+     * @return shared level information, which states can be constructed from
+     * @throw std::invalid_argument if a different level with the same id is registered, as its snapshots would be
+     *        decoded against the wrong board
+     */
+    [[nodiscard]] auto intern(const GameParameters &params) -> std::shared_ptr<const SharedStateInfo>;
+
+    /**
+     * Get the shared level for the given board string, registering it the first time it is seen.
+     * @see intern(const GameParameters &)
+     * @param board_str Board string of the level
+     * @param workshop_swap Whether the workshops are swapped
+     * @return shared level information, which states can be constructed from
+     * @throw std::invalid_argument if a different level with the same id is registered
+     */
+    [[nodiscard]] auto intern(const std::string &board_str, bool workshop_swap)
+        -> std::shared_ptr<const SharedStateInfo>;
+
+    /**
+     * Register a level and keep it alive until unpin(), so its snapshots can be loaded without another owner.
+     * @param level Shared level information
+     * @return registered level, which is either level or an equal level registered before
+     * @throw std::invalid_argument if a different level with the same id is already registered
+     */
+    auto pin(std::shared_ptr<const SharedStateInfo> level) -> std::shared_ptr<const SharedStateInfo>;
+
+    /**
+     * Stop keeping a pinned level alive. It stays registered while other owners hold it.
+     * @param level_id Id of the level
+     * @return true if the level was pinned
+     */
+    auto unpin(uint64_t level_id) -> bool;
+
+    /**
+     * Find a registered level.
+     * @param level_id Id of the level
+     * @return shared level information, or nullptr if no level with the id is registered
+     */
+    [[nodiscard]] auto find(uint64_t level_id) const -> std::shared_ptr<const SharedStateInfo>;
+
+    /**
+     * Get the number of registered levels which are still alive.
+     * @return number of levels
+     */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+private:
+    mutable std::shared_mutex mutex_;    // Shared for lookups, exclusive for registering
+    std::unordered_map<uint64_t, std::weak_ptr<const SharedStateInfo>> levels_;
+    std::unordered_map<uint64_t, std::shared_ptr<const SharedStateInfo>> pinned_;
+    std::size_t prune_size_ = 0;    // Number of entries at which expired levels are next removed
+};
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_LEVEL_REGISTRY_H_
@@ -0,0 +1,205 @@
+#include "level_set.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "level_registry.h"
+#include "util.h"
+
+namespace craftworld {
+
+namespace {
+// Levels in the table are aligned to this many bytes
+constexpr std::size_t kLevelAlignment = 8;
+
+struct LevelSetHeader {
+    uint32_t magic = kLevelSetMagic;
+    uint32_t version = kLevelSetVersion;
+    uint64_t num_levels = 0;
+    uint32_t stride = 0;       // Bytes per level in the table
+    uint32_t max_cells = 0;    // Cells per level in the table, levels with fewer cells are zero padded
+    uint64_t reserved = 0;
+};
+
+// Followed by max_cells bytes, one element per cell
+struct LevelEntry {
+    uint64_t zorb_hash = 0;    // Hash of the starting board
+    uint32_t agent_idx = 0;
+    uint16_t rows = 0;
+    uint16_t cols = 0;
+    uint8_t goal = 0;
+    std::array<uint8_t, 7> reserved{};
+};
+
+static_assert(std::has_unique_object_representations_v<LevelSetHeader>);
+static_assert(std::has_unique_object_representations_v<LevelEntry>);
+static_assert(sizeof(LevelSetHeader) % kLevelAlignment == 0 && sizeof(LevelEntry) % kLevelAlignment == 0);
+
+auto align(std::size_t size) noexcept -> std::size_t {
+    return (size + kLevelAlignment - 1) / kLevelAlignment * kLevelAlignment;
+}
+}    // namespace
+
+LevelSet::LevelSet(const std::string &path, bool workshop_swap) : file_(path), workshop_swap_(workshop_swap) {
+    LevelSetHeader header;
+    if (file_.size() >= sizeof(uint32_t) && std::memcmp(file_.data(), &header.magic, sizeof(uint32_t)) == 0) {
+        if (file_.size() < sizeof(header)) {
+            throw std::runtime_error(path + " is a corrupt binary levelset.");
+        }
+        std::memcpy(&header, file_.data(), sizeof(header));
+        if (header.version != kLevelSetVersion) {
+            throw std::runtime_error(path + " has an unsupported binary levelset version.");
+        }
+        if (header.stride < align(sizeof(LevelEntry) + header.max_cells) || header.stride % kLevelAlignment != 0 ||
+            (file_.size() - sizeof(header)) / header.stride != header.num_levels ||
+            (file_.size() - sizeof(header)) % header.stride != 0) {
+            throw std::runtime_error(path + " is a corrupt binary levelset.");
+        }
+        binary_ = true;
+        size_ = static_cast<std::size_t>(header.num_levels);
+        table_ = file_.data() + sizeof(header);
+        stride_ = header.stride;
+        max_cells_ = header.max_cells;
+    } else {
+        const auto *data = reinterpret_cast<const char *>(file_.data());    // NOLINT(*-reinterpret-cast)
+        const char *end = data + file_.size();
+        for (const char *pos = data; pos < end;) {
+            const auto *line_end =
+                static_cast<const char *>(std::memchr(pos, '\n', static_cast<std::size_t>(end - pos)));
+            line_end = line_end == nullptr ? end : line_end;
+            const char *text_end = line_end;
+            if (text_end != pos && *std::prev(text_end) == '\r') {
+                --text_end;
+            }
+            if (text_end != pos) {
+                lines_.push_back({static_cast<std::size_t>(pos - data), static_cast<std::size_t>(text_end - pos)});
+            }
+            pos = line_end == end ? end : std::next(line_end);
+        }
+        size_ = lines_.size();
+    }
+    levels_.resize(size_);
+}
+
+auto LevelSet::ReadBinaryBoard(std::size_t index) const -> Board {
+    const uint8_t *record = table_ + (index * stride_);
+    LevelEntry entry;
+    std::memcpy(&entry, record, sizeof(entry));
+    const std::size_t num_cells = static_cast<std::size_t>(entry.rows) * entry.cols;
+    if (num_cells == 0 || num_cells > max_cells_ || entry.agent_idx >= num_cells) {
+        throw std::invalid_argument("Level dimensions out of range in binary levelset.");
+    }
+    if (entry.goal < kPrimitiveStart || entry.goal >= (kNumPrimitive + kNumRecipeTypes + kPrimitiveStart)) {
+        throw std::invalid_argument("Unknown goal element.");
+    }
+    Board board(entry.rows, entry.cols, static_cast<Element>(entry.goal));
+    board.zorb_hash = entry.zorb_hash;
+    board.agent_idx = entry.agent_idx;
+    const uint8_t *cells = record + sizeof(entry);
+    for (std::size_t i = 0; i < num_cells; ++i) {
+        if (cells[i] >= kNumElements) {
+            throw std::invalid_argument("Unknown element type in binary levelset.");
+        }
+        board.item(i) = static_cast<Element>(cells[i]);
+    }
+    return board;
+}
+
+auto LevelSet::board_str(std::size_t index) const -> std::string {
+    if (index >= size_) {
+        throw std::out_of_range("Levelset index out of range.");
+    }
+    if (binary_) {
+        return util::to_board_str(ReadBinaryBoard(index));
+    }
+    const Line &line = lines_[index];
+    return {reinterpret_cast<const char *>(file_.data()) + line.offset, line.length};    // NOLINT(*-reinterpret-cast)
+}
+
+auto LevelSet::level(std::size_t index) const -> std::shared_ptr<const SharedStateInfo> {
+    std::shared_ptr<const SharedStateInfo> level = std::atomic_load(&levels_.at(index));
+    if (level) {
+        return level;
+    }
+    // Build outside of any lock, if multiple threads race only the first result is cached
+    std::shared_ptr<const SharedStateInfo> built;
+    if (binary_) {
+        Board board = ReadBinaryBoard(index);
+        std::string board_str = util::to_board_str(board);
+        built = LevelRegistry::instance().add(
+            std::make_shared<const SharedStateInfo>(std::move(board_str), workshop_swap_, std::move(board)));
+    } else {
+        built = LevelRegistry::instance().add(board_str(index), workshop_swap_);
+    }
+    if (std::atomic_compare_exchange_strong(&levels_[index], &level, built)) {
+        return built;
+    }
+    return level;
+}
+
+auto LevelSet::make_state(std::size_t index) const -> CraftWorldGameState {
+    return CraftWorldGameState(level(index));
+}
+
+auto LevelSet::save_binary(const std::string &path) const -> std::size_t {
+    // Only the table data is kept while building the levels, as converting a large levelset through level() would
+    // keep every level alive
+    std::vector<LevelEntry> entries;
+    std::vector<uint8_t> cells;
+    entries.reserve(size_);
+    std::size_t max_cells = 0;
+    std::size_t num_reformatted = 0;
+    for (std::size_t i = 0; i < size_; ++i) {
+        const SharedStateInfo level(board_str(i), workshop_swap_);
+        const Board &board = level.initial_board;
+        if (board.rows > UINT16_MAX || board.cols > UINT16_MAX) {
+            throw std::invalid_argument("Board dimensions are too large for the binary levelset format.");
+        }
+        LevelEntry entry;
+        entry.zorb_hash = board.zorb_hash;
+        entry.agent_idx = static_cast<uint32_t>(board.agent_idx);
+        entry.rows = static_cast<uint16_t>(board.rows);
+        entry.cols = static_cast<uint16_t>(board.cols);
+        entry.goal = static_cast<uint8_t>(board.goal);
+        entries.push_back(entry);
+        for (const Element el : board.grid) {
+            cells.push_back(static_cast<uint8_t>(el));
+        }
+        max_cells = std::max(max_cells, board.grid.size());
+        num_reformatted += static_cast<std::size_t>(util::to_board_str(board) != level.game_board_str);
+    }
+
+    LevelSetHeader header;
+    header.num_levels = entries.size();
+    header.max_cells = static_cast<uint32_t>(max_cells);
+    header.stride = static_cast<uint32_t>(align(sizeof(LevelEntry) + max_cells));
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Unable to open " + path + " for writing.");
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));    // NOLINT(*-reinterpret-cast)
+    std::vector<uint8_t> record(header.stride);
+    const uint8_t *level_cells = cells.data();
+    for (const LevelEntry &entry : entries) {
+        const std::size_t num_cells = static_cast<std::size_t>(entry.rows) * entry.cols;
+        std::fill(record.begin(), record.end(), 0);
+        std::memcpy(record.data(), &entry, sizeof(entry));
+        std::memcpy(record.data() + sizeof(entry), level_cells, num_cells);
+        level_cells += num_cells;
+        out.write(reinterpret_cast<const char *>(record.data()),    // NOLINT(*-reinterpret-cast)
+                  static_cast<std::streamsize>(record.size()));
+    }
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Unable to write levelset to " + path + ".");
+    }
+    return num_reformatted;
+}
+
+}    // namespace craftworld
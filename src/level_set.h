@@ -0,0 +1,113 @@
+#ifndef CRAFTWORLD_LEVEL_SET_H_
+#define CRAFTWORLD_LEVEL_SET_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "craftworld_base.h"
+#include "mapped_file.h"
+
+namespace craftworld {
+
+// Magic number at the start of every binary levelset ("CWLS" in little-endian byte order)
+constexpr uint32_t kLevelSetMagic = 0x534C5743;
+constexpr uint32_t kLevelSetVersion = 1;
+
+/**
+ * Memory mapped levelset file, in either of two formats:
+ *   - Text: one board string per line (such as scripts/train.txt), empty lines are skipped
+ *   - Binary: written by save_binary() and detected by its magic number. A header is followed by a fixed stride table
+ *     with the dimensions, goal, agent index and initial hash of each level, and one byte per cell.
+ * Opening a text levelset only maps the file and indexes its lines, opening a binary levelset is O(1). Each level is
+ * built on first access and cached, and is added to the global LevelRegistry so snapshots of its states can be loaded.
+ * Levels of a binary levelset use the board string given by util::to_board_str(), which is the format written by
+ * scripts/generate_levelset.py.
+ * All methods are const and can be called from multiple threads.
+ */
+class LevelSet {
+public:
+    /**
+     * @param path Levelset file to open
+     * @param workshop_swap Whether the workshops are swapped in every level
+     * @throw std::runtime_error if the file cannot be opened or is a corrupt binary levelset
+     */
+    explicit LevelSet(const std::string &path, bool workshop_swap = false);
+
+    /**
+     * Get the number of levels in the set.
+     * @return number of levels
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+        return size_;
+    }
+
+    /**
+     * Check if the levelset was opened from the binary format.
+     * @return true if binary, false if text
+     */
+    [[nodiscard]] auto is_binary() const noexcept -> bool {
+        return binary_;
+    }
+
+    /**
+     * Get the board string of a level, without building the level.
+     * @param index Level index
+     * @return board string
+     * @throw std::out_of_range if index is not less than size()
+     * @throw std::invalid_argument if the level of a binary levelset is malformed
+     */
+    [[nodiscard]] auto board_str(std::size_t index) const -> std::string;
+
+    /**
+     * Get a level, building it on first access.
+     * @param index Level index
+     * @return shared level information, which states can be constructed from
+     * @throw std::out_of_range if index is not less than size()
+     * @throw std::invalid_argument if the level is malformed
+     */
+    [[nodiscard]] auto level(std::size_t index) const -> std::shared_ptr<const SharedStateInfo>;
+
+    /**
+     * Construct the starting state of a level.
+     * @param index Level index
+     * @return state
+     * @throw std::out_of_range if index is not less than size()
+     * @throw std::invalid_argument if the level is malformed
+     */
+    [[nodiscard]] auto make_state(std::size_t index) const -> CraftWorldGameState;
+
+    /**
+     * Write all levels in the binary format.
+     * @param path Binary levelset file to create, an existing file is overwritten
+     * @return number of levels whose text board string differs from util::to_board_str(), so have a different level
+     *         id in the binary levelset
+     * @throw std::invalid_argument if a level is malformed
+     * @throw std::runtime_error if the file cannot be written
+     */
+    auto save_binary(const std::string &path) const -> std::size_t;
+
+private:
+    struct Line {
+        std::size_t offset;
+        std::size_t length;
+    };
+
+    [[nodiscard]] auto ReadBinaryBoard(std::size_t index) const -> Board;
+
+    MappedFile file_;
+    bool workshop_swap_;
+    bool binary_ = false;
+    std::size_t size_ = 0;
+    std::vector<Line> lines_;           // Text format only
+    const uint8_t *table_ = nullptr;    // Binary format only, start of the level table
+    std::size_t stride_ = 0;            // Binary format only, bytes per level
+    std::size_t max_cells_ = 0;         // Binary format only, cells per level in the table
+    // Built levels, nullptr until first accessed. Accessed with the std::atomic_* shared_ptr functions.
+    mutable std::vector<std::shared_ptr<const SharedStateInfo>> levels_;
+};
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_LEVEL_SET_H_
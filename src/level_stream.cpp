@@ -0,0 +1,159 @@
+#include "level_stream.h"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace craftworld {
+
+namespace {
+// Consecutive seeds tried for the first level before the map is considered too small for every seed
+constexpr uint64_t kMaxFirstLevelAttempts = 64;
+}    // namespace
+
+LevelStream::LevelStream(const LevelGeneratorConfig &config, uint64_t first_seed, std::size_t capacity,
+                         std::size_t num_threads, bool workshop_swap)
+    : config_(config), first_seed_(first_seed), workshop_swap_(workshop_swap), queue_(capacity) {
+    if (num_threads == 0) {
+        throw std::invalid_argument("Level stream needs at least one generator thread.");
+    }
+    check_generator_config(config_);
+    // The first level is generated here, so a map on which no seed can be placed is reported by the constructor
+    LevelPtr level;
+    for (uint64_t offset = 0; !level; ++offset) {
+        try {
+            level = std::make_shared<const SharedStateInfo>(generate_level(config_, first_seed_ + offset),
+                                                            workshop_swap_);
+            next_seed_offset_.store(offset + 1, std::memory_order_relaxed);
+        } catch (const std::invalid_argument &) {
+            if (offset + 1 == kMaxFirstLevelAttempts) {
+                throw;
+            }
+            num_skipped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    (void)queue_.try_push(level);
+    num_generated_.store(1, std::memory_order_relaxed);
+
+    threads_.reserve(num_threads);
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        threads_.emplace_back([this]() { GeneratorLoop(); });
+    }
+}
+
+LevelStream::~LevelStream() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        stop_.store(true);
+    }
+    not_full_cv_.notify_all();
+    not_empty_cv_.notify_all();
+    for (auto &thread : threads_) {
+        thread.join();
+    }
+}
+
+void LevelStream::GeneratorLoop() noexcept {
+    while (!stop_.load(std::memory_order_relaxed)) {
+        const uint64_t seed = first_seed_ + next_seed_offset_.fetch_add(1, std::memory_order_relaxed);
+        LevelPtr level;
+        try {
+            level = std::make_shared<const SharedStateInfo>(generate_level(config_, seed), workshop_swap_);
+        } catch (const std::invalid_argument &) {
+            // The config was checked by the constructor, so only this seed's map is too crowded to place every element
+            num_skipped_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        } catch (...) {
+            // Anything else, such as running out of memory, stops the stream
+            {
+                const std::lock_guard<std::mutex> lock(mutex_);
+                if (!failed_.load(std::memory_order_relaxed)) {
+                    error_ = std::current_exception();
+                    failed_.store(true, std::memory_order_release);
+                }
+                stop_.store(true);
+            }
+            not_full_cv_.notify_all();
+            not_empty_cv_.notify_all();
+            return;
+        }
+        Push(std::move(level));
+    }
+}
+
+void LevelStream::Push(LevelPtr level) {
+    if (!queue_.try_push(level)) {
+        // Queue is full, so wait for a consumer to make space
+        std::unique_lock<std::mutex> lock(mutex_);
+        num_waiting_generators_.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool pushed = false;
+        not_full_cv_.wait(lock, [&]() { return stop_.load() || (pushed = queue_.try_push(level)); });
+        num_waiting_generators_.fetch_sub(1);
+        if (!pushed) {
+            return;
+        }
+    }
+    num_generated_.fetch_add(1, std::memory_order_relaxed);
+    WakeConsumer();
+}
+
+auto LevelStream::try_pop() -> std::shared_ptr<const SharedStateInfo> {
+    LevelPtr level;
+    if (!queue_.try_pop(level)) {
+        RethrowError();
+        return nullptr;
+    }
+    WakeGenerator();
+    return level;
+}
+
+auto LevelStream::pop() -> std::shared_ptr<const SharedStateInfo> {
+    LevelPtr level = try_pop();
+    if (level) {
+        return level;
+    }
+    // Queue is empty, so wait for a generator
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        num_waiting_consumers_.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        not_empty_cv_.wait(lock, [&]() { return queue_.try_pop(level) || failed_.load(); });
+        num_waiting_consumers_.fetch_sub(1);
+    }
+    if (!level) {
+        RethrowError();
+    }
+    WakeGenerator();
+    return level;
+}
+
+auto LevelStream::make_state() -> CraftWorldGameState {
+    return CraftWorldGameState(pop());
+}
+
+// Waiters increment their count before checking the queue, so either they see the queue change or the count is seen
+// here. Taking the mutex makes sure a waiter which has checked the queue is waiting before it is notified.
+void LevelStream::WakeGenerator() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_waiting_generators_.load(std::memory_order_relaxed) > 0) {
+        { const std::lock_guard<std::mutex> lock(mutex_); }
+        not_full_cv_.notify_one();
+    }
+}
+
+void LevelStream::WakeConsumer() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_waiting_consumers_.load(std::memory_order_relaxed) > 0) {
+        { const std::lock_guard<std::mutex> lock(mutex_); }
+        not_empty_cv_.notify_one();
+    }
+}
+
+void LevelStream::RethrowError() {
+    if (failed_.load(std::memory_order_acquire)) {
+        std::rethrow_exception(error_);
+    }
+}
+
+}    // namespace craftworld
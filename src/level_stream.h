@@ -0,0 +1,124 @@
+#ifndef CRAFTWORLD_LEVEL_STREAM_H_
+#define CRAFTWORLD_LEVEL_STREAM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "craftworld_base.h"
+#include "level_generator.h"
+#include "mpmc_queue.h"
+
+namespace craftworld {
+
+/**
+ * Endless stream of generated levels, for training on fresh levels instead of a fixed levelset.
+ * Background threads generate levels with seeds first_seed, first_seed + 1, ... and keep a bounded lock-free queue of
+ * ready levels topped up, so drawing a level is a queue pop as long as the generators keep up.
+ * Levels arrive in roughly seed order; with multiple threads the exact order is not deterministic. Seeds whose map is
+ * too crowded to place every element are skipped, so a crowded config thins the stream instead of stopping it.
+ * Streamed levels are not added to the LevelRegistry, so an endless stream does not grow the registry. Snapshots of
+ * their states can only be loaded after interning the level, see LevelRegistry::intern().
+ * All methods can be called from multiple threads.
+ */
+class LevelStream {
+public:
+    /**
+     * @param config Generator configuration
+     * @param first_seed Seed of the first generated level
+     * @param capacity Minimum number of ready levels to keep queued
+     * @param num_threads Number of generator threads
+     * @param workshop_swap Whether the workshops are swapped in every level
+     * @throw std::invalid_argument if the config is invalid, no level can be placed on the first seeds, or capacity or
+     *        num_threads is 0
+     */
+    LevelStream(const LevelGeneratorConfig &config, uint64_t first_seed, std::size_t capacity = 1024,
+                std::size_t num_threads = 1, bool workshop_swap = false);
+    ~LevelStream();
+
+    LevelStream(const LevelStream &) = delete;
+    LevelStream(LevelStream &&) = delete;
+    auto operator=(const LevelStream &) -> LevelStream & = delete;
+    auto operator=(LevelStream &&) -> LevelStream & = delete;
+
+    /**
+     * Get the number of ready levels the queue can hold.
+     * @return capacity
+     */
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t {
+        return queue_.capacity();
+    }
+
+    /**
+     * Get the number of levels generated so far, including the ones still queued.
+     * @return number of levels
+     */
+    [[nodiscard]] auto num_generated() const noexcept -> std::size_t {
+        return num_generated_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the number of seeds skipped so far, as their map was too crowded to place every element.
+     * @return number of seeds
+     */
+    [[nodiscard]] auto num_skipped() const noexcept -> std::size_t {
+        return num_skipped_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the next level without waiting.
+     * @return shared level information, or nullptr if no level is ready
+     * @throw std::bad_alloc or the other error which stopped the generators, once the queued levels are used up
+     */
+    [[nodiscard]] auto try_pop() -> std::shared_ptr<const SharedStateInfo>;
+
+    /**
+     * Get the next level, waiting for one to be generated if none is ready.
+     * @return shared level information, which states can be constructed from
+     * @throw std::bad_alloc or the other error which stopped the generators, once the queued levels are used up
+     */
+    [[nodiscard]] auto pop() -> std::shared_ptr<const SharedStateInfo>;
+
+    /**
+     * Construct the starting state of the next level, waiting for one to be generated if none is ready.
+     * @return state
+     * @throw std::bad_alloc or the other error which stopped the generators, once the queued levels are used up
+     */
+    [[nodiscard]] auto make_state() -> CraftWorldGameState;
+
+private:
+    using LevelPtr = std::shared_ptr<const SharedStateInfo>;
+
+    void GeneratorLoop() noexcept;
+    void Push(LevelPtr level);
+    void WakeGenerator();
+    void WakeConsumer();
+    void RethrowError();
+
+    LevelGeneratorConfig config_;
+    uint64_t first_seed_;
+    bool workshop_swap_;
+    MPMCQueue<LevelPtr> queue_;
+    std::atomic<uint64_t> next_seed_offset_{0};    // Offset from first_seed_ of the next level to generate
+    std::atomic<std::size_t> num_generated_{0};
+    std::atomic<std::size_t> num_skipped_{0};
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> failed_{false};
+    std::exception_ptr error_;    // Written once before failed_ is set
+    // Slow path only: generators wait when the queue is full, and pop() waits when it is empty
+    std::mutex mutex_;
+    std::condition_variable not_full_cv_;
+    std::condition_variable not_empty_cv_;
+    std::atomic<std::size_t> num_waiting_generators_{0};
+    std::atomic<std::size_t> num_waiting_consumers_{0};
+    std::vector<std::thread> threads_;
+};
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_LEVEL_STREAM_H_
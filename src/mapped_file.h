@@ -0,0 +1,47 @@
+#ifndef CRAFTWORLD_MAPPED_FILE_H_
+#define CRAFTWORLD_MAPPED_FILE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace craftworld {
+
+/**
+ * Read-only view of a whole file.
+ * The file is memory mapped on POSIX systems, elsewhere it is read into memory once.
+ * The contents are never modified, so a single MappedFile can be read from multiple threads.
+ */
+class MappedFile {
+public:
+    /**
+     * @param path File to map
+     * @throw std::runtime_error if the file cannot be opened or mapped
+     */
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    auto operator=(const MappedFile &) -> MappedFile & = delete;
+    auto operator=(MappedFile &&other) noexcept -> MappedFile &;
+
+    [[nodiscard]] auto data() const noexcept -> const uint8_t * {
+        return data_;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+        return size_;
+    }
+
+private:
+    void Unmap() noexcept;
+
+    const uint8_t *data_ = nullptr;
+    std::size_t size_ = 0;
+    std::vector<uint8_t> buffer_;    // Holds the contents when memory mapping is not available
+};
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_MAPPED_FILE_H_
@@ -0,0 +1,121 @@
+#ifndef CRAFTWORLD_MPMC_QUEUE_H_
+#define CRAFTWORLD_MPMC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace craftworld {
+
+/**
+ * Bounded lock-free multi-producer multi-consumer queue (Dmitry Vyukov's design).
+ * Each cell carries a sequence number which tells producers and consumers whether it is free or holds a value, so
+ * pushing and popping take a single CAS on the shared position and never allocate.
+ */
+template <typename T>
+class MPMCQueue {
+public:
+    /**
+     * @param capacity Minimum number of values the queue can hold, rounded up to a power of two
+     * @throw std::invalid_argument if capacity is 0
+     */
+    explicit MPMCQueue(std::size_t capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("Queue capacity must be positive.");
+        }
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        cells_ = std::make_unique<Cell[]>(size);    // NOLINT(*-avoid-c-arrays)
+        for (std::size_t i = 0; i < size; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPMCQueue(const MPMCQueue &) = delete;
+    MPMCQueue(MPMCQueue &&) = delete;
+    auto operator=(const MPMCQueue &) -> MPMCQueue & = delete;
+    auto operator=(MPMCQueue &&) -> MPMCQueue & = delete;
+    ~MPMCQueue() = default;
+
+    /**
+     * Get the number of values the queue can hold.
+     * @return capacity
+     */
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t {
+        return mask_ + 1;
+    }
+
+    /**
+     * Push a value if the queue is not full.
+     * @param value Value to push, only moved from on success
+     * @return true if pushed, false if the queue is full
+     */
+    auto try_push(T &value) noexcept -> bool {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells_[pos & mask_];
+            const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Pop the oldest value if the queue is not empty.
+     * @param value Set to the popped value on success
+     * @return true if popped, false if the queue is empty
+     */
+    auto try_pop(T &value) noexcept -> bool {
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells_[pos & mask_];
+            const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.value = T();
+                    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    static constexpr std::size_t kCacheLineSize = 64;
+
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;    // NOLINT(*-avoid-c-arrays)
+    std::size_t mask_ = 0;
+    // Producers and consumers contend on different cache lines
+    alignas(kCacheLineSize) std::atomic<std::size_t> enqueue_pos_{0};
+    alignas(kCacheLineSize) std::atomic<std::size_t> dequeue_pos_{0};
+};
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_MPMC_QUEUE_H_
@@ -0,0 +1,114 @@
+#ifndef CRAFTWORLD_OBSERVATION_H_
+#define CRAFTWORLD_OBSERVATION_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include "definitions.h"
+
+namespace craftworld {
+
+// Observation writers shared by CraftWorldGameState and StateView.
+// The Source type provides the board and inventory being observed:
+//   rows(), cols()           Board dimensions
+//   cell(index)              Element at the flat board index
+//   goal()                   Goal element of the level
+//   for_each_inventory(f)    Calls f(element, count) for every element with a non-zero count
+
+// Shape of an observation with the given number of channels in the requested layout
+inline auto make_observation_shape(int channels, std::size_t rows, std::size_t cols, ObservationLayout layout) noexcept
+    -> std::array<int, 3> {
+    if (layout == ObservationLayout::kHWC) {
+        return {static_cast<int>(rows), static_cast<int>(cols), channels};
+    }
+    return {channels, static_cast<int>(rows), static_cast<int>(cols)};
+}
+
+// Number of channels of the given kind of observation
+constexpr auto observation_channels(ObservationType obs_type) noexcept -> std::size_t {
+    switch (obs_type) {
+        case ObservationType::kBinary:
+            return kNumBinaryChannels;
+        case ObservationType::kEnvironment:
+            return kNumEnvironment + kNumPrimitive;
+        case ObservationType::kFull:
+        default:
+            return kNumChannels;
+    }
+}
+
+// Flat index of the (channel, cell) pair in the requested layout
+constexpr auto obs_index(std::size_t channel, std::size_t cell, std::size_t num_channels, std::size_t channel_length,
+                         ObservationLayout layout) noexcept -> std::size_t {
+    return layout == ObservationLayout::kHWC ? (cell * num_channels) + channel : (channel * channel_length) + cell;
+}
+
+// Set every cell of the given channel to value
+template <typename T>
+void fill_channel(T *obs, std::size_t channel, T value, std::size_t num_channels, std::size_t channel_length,
+                  ObservationLayout layout) noexcept {
+    if (layout == ObservationLayout::kHWC) {
+        for (std::size_t i = 0; i < channel_length; ++i) {
+            obs[(i * num_channels) + channel] = value;
+        }
+    } else {
+        std::fill_n(obs + (channel * channel_length), channel_length, value);
+    }
+}
+
+// Board environment + primitives + agent
+template <typename T, typename Source>
+void write_board_channels(T *obs, const Source &source, std::size_t num_channels, ObservationLayout layout) noexcept {
+    const std::size_t channel_length = source.rows() * source.cols();
+    std::fill_n(obs, num_channels * channel_length, T(0.0F));
+    for (std::size_t i = 0; i < channel_length; ++i) {
+        const auto el = source.cell(i);
+        if (el != Element::kEmpty) {
+            obs[obs_index(static_cast<std::size_t>(el), i, num_channels, channel_length, layout)] = T(1.0F);
+        }
+    }
+}
+
+template <typename T, typename Source>
+void write_observation(T *obs, const Source &source, ObservationLayout layout) noexcept {
+    const std::size_t channel_length = source.rows() * source.cols();
+    write_board_channels(obs, source, kNumChannels, layout);
+    // Inventory (entire channel is filled with # of that item)
+    source.for_each_inventory([&](Element inv_el, std::size_t inv_count) {
+        const auto channel = static_cast<std::size_t>(inv_el) + kNumPrimitive;
+        fill_channel(obs, channel, T(static_cast<float>(inv_count)), kNumChannels, channel_length, layout);
+    });
+    // Current goal for this level (26-34)
+    const std::size_t channel = kNumChannels - kNumGoals + static_cast<std::size_t>(source.goal()) - kRecipeStart;
+    fill_channel(obs, channel, T(1.0F), kNumChannels, channel_length, layout);
+}
+
+template <typename T, typename Source>
+void write_binary_observation(T *obs, const Source &source, ObservationLayout layout) noexcept {
+    const std::size_t channel_length = source.rows() * source.cols();
+    write_board_channels(obs, source, kNumBinaryChannels, layout);
+    // Inventory (entire channel is filled with maximum of 2 elements on consecutive binary channels)
+    source.for_each_inventory([&](Element inv_el, std::size_t inv_count) {
+        auto channel = kNumPrimitive + kNumEnvironment + 2 * (static_cast<std::size_t>(inv_el) - kNumEnvironment);
+        fill_channel(obs, channel, T(1.0F), kNumBinaryChannels, channel_length, layout);
+        if (inv_count > 1) {
+            ++channel;
+            fill_channel(obs, channel, T(1.0F), kNumBinaryChannels, channel_length, layout);
+        }
+    });
+    // Current goal for this level (26-34)
+    const std::size_t channel = kNumEnvironment + kNumPrimitive + (2 * kNumInventory) +
+                                (static_cast<std::size_t>(source.goal()) - kRecipeStart);
+    fill_channel(obs, channel, T(1.0F), kNumBinaryChannels, channel_length, layout);
+}
+
+template <typename T, typename Source>
+void write_environment_observation(T *obs, const Source &source, ObservationLayout layout) noexcept {
+    // Board environment + primitives + agent (0-11)
+    write_board_channels(obs, source, kNumEnvironment + kNumPrimitive, layout);
+}
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_OBSERVATION_H_
@@ -1,6 +1,4 @@
 import os
-import string
-import subprocess
 
 import cv2
 
@@ -9,55 +7,71 @@ TILES_PATH = os.path.join(os.path.dirname(SCRIPT_PATH), "assets")
 ASSETS_ALL = os.path.join(SCRIPT_PATH, "assets_all.inc")
 ASSETS_STR = (
     "{0}\n"
-    "\n"
-    "const std::unordered_map<Element, std::vector<unsigned char>> img_asset_map {{\n"
+    "// Sprite data indexed by element\n"
+    "constexpr std::array<const unsigned char *, kNumElements> img_asset_table{{\n"
     "{1}"
     "}};\n"
 )
 
+# Asset file names in element order
+ELEMENT_ASSETS = [
+    "agent",
+    "wall",
+    "workshop1",
+    "workshop2",
+    "workshop3",
+    "furnace",
+    "water",
+    "stone",
+    "iron",
+    "tin",
+    "copper",
+    "wood",
+    "grass",
+    "gold",
+    "gem",
+    "bronze_bar",
+    "stick",
+    "plank",
+    "rope",
+    "nails",
+    "bronze_hammer",
+    "bronze_pick",
+    "bridge",
+    "iron_pick",
+    "gold_bar",
+    "gem_ring",
+    "empty",
+]
+BYTES_PER_LINE = 12
+# Must match SPRITE_WIDTH and SPRITE_HEIGHT in craftworld_base.h
+SPRITE_WIDTH = 32
+SPRITE_HEIGHT = 32
 
-def main():
-    # asset_headers = ""
-    asset_mappings = ""
-    assets_data = ""
-    for file in os.listdir(TILES_PATH):
-        if file.endswith(".png"):
-            img = cv2.cvtColor(
-                cv2.imread("{}/{}".format(TILES_PATH, file)), cv2.COLOR_BGR2RGB
-            ).flatten()
-            asset_name = file[:-4]
-            binary_file_name = asset_name + ".bin"
-            binary_file_path = TILES_PATH + "/" + binary_file_name
-            img = bytearray(img)
-            with open(binary_file_path, "wb") as f:
-                f.write(img)
-
-            # create header
-            session = subprocess.run(
-                ["xxd", "-i", binary_file_name],
-                stdout=subprocess.PIPE,
-                stderr=subprocess.PIPE,
-                cwd=TILES_PATH,
-            )
-            stdout = session.stdout.decode("utf-8")
-            stdout = stdout.replace("unsigned", "static const unsigned")
-            stdout = stdout.replace(
-                "static const unsigned char {}_bin[]".format(asset_name),
-                "static const std::vector<unsigned char> {}_bin".format(asset_name),
-            )
 
-            assets_data += stdout
+def to_array(asset_name, data):
+    lines = []
+    for i in range(0, len(data), BYTES_PER_LINE):
+        lines.append(
+            "  " + ", ".join("0x{:02x}".format(b) for b in data[i : i + BYTES_PER_LINE])
+        )
+    return (
+        "constexpr unsigned char {0}_bin[] = {{\n{1}\n}};\n"
+        'static_assert(sizeof({0}_bin) == SPRITE_DATA_LEN, "{0} sprite is not {2}x{3} RGB.");\n'
+    ).format(asset_name, ",\n".join(lines), SPRITE_WIDTH, SPRITE_HEIGHT)
 
-            os.remove(binary_file_path)
 
-            # Add to master include list
-            internal_name = "Element::k" + string.capwords(
-                asset_name.replace("_", " ")
-            ).replace(" ", "")
-            asset_mappings += "{{ {0}, {1}_bin }},\n".format(internal_name, asset_name)
+def main():
+    asset_mappings = ""
+    assets_data = ""
+    for asset_name in ELEMENT_ASSETS:
+        img = cv2.cvtColor(
+            cv2.imread("{}/{}.png".format(TILES_PATH, asset_name)), cv2.COLOR_BGR2RGB
+        ).flatten()
+        assets_data += to_array(asset_name, bytearray(img))
+        asset_mappings += "    {0}_bin,\n".format(asset_name)
 
     # create master include
-    print(ASSETS_STR.format(assets_data, asset_mappings))
     with open(ASSETS_ALL, "w") as f:
         f.write(ASSETS_STR.format(assets_data, asset_mappings))
 
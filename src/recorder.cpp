@@ -0,0 +1,98 @@
+#include "recorder.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace craftworld {
+
+EpisodeRecorder::EpisodeRecorder(const CraftWorldGameState &state, std::string path, VideoFormat format,
+                                 int tile_size, int fps)
+    : renderer_(state, tile_size), path_(std::move(path)), format_(format), fps_(fps) {
+    if (fps_ <= 0) {
+        throw std::invalid_argument("Frame rate must be positive.");
+    }
+    if (format_ == VideoFormat::kY4M) {
+        out_.open(path_, std::ios::binary | std::ios::trunc);
+        if (!out_) {
+            throw std::runtime_error("Unable to open " + path_ + " for writing.");
+        }
+    }
+}
+
+EpisodeRecorder::~EpisodeRecorder() {
+    if (out_.is_open()) {
+        out_.close();
+    }
+}
+
+void EpisodeRecorder::record() {
+    const std::vector<uint8_t> &frame = renderer_.render();
+    if (format_ == VideoFormat::kY4M) {
+        WriteY4MFrame(frame);
+    } else {
+        WritePPMFrame(frame);
+    }
+    ++num_frames_;
+}
+
+void EpisodeRecorder::close() {
+    if (out_.is_open()) {
+        out_.close();
+    }
+}
+
+auto EpisodeRecorder::num_frames() const noexcept -> std::size_t {
+    return num_frames_;
+}
+
+void EpisodeRecorder::WriteY4MFrame(const std::vector<uint8_t> &frame) {
+    const auto shape = renderer_.image_shape();
+    if (num_frames_ == 0) {
+        y4m_shape_ = shape;
+        out_ << "YUV4MPEG2 W" << shape[1] << " H" << shape[0] << " F" << fps_ << ":1 Ip A1:1 C444\n";
+    } else if (shape != y4m_shape_) {
+        // A Y4M stream has a single frame size, set by its header
+        throw std::runtime_error("Frame size differs from the first frame of " + path_ + ".");
+    }
+
+    // BT.601 limited range, planar Y then U then V
+    const std::size_t num_pixels = shape[0] * shape[1];
+    planes_.resize(3 * num_pixels);
+    uint8_t *y_plane = planes_.data();
+    uint8_t *u_plane = y_plane + num_pixels;
+    uint8_t *v_plane = u_plane + num_pixels;
+    for (std::size_t i = 0; i < num_pixels; ++i) {
+        const int r = frame[(3 * i) + 0];
+        const int g = frame[(3 * i) + 1];
+        const int b = frame[(3 * i) + 2];
+        y_plane[i] = static_cast<uint8_t>((((66 * r) + (129 * g) + (25 * b) + 128) >> 8) + 16);
+        u_plane[i] = static_cast<uint8_t>((((-38 * r) - (74 * g) + (112 * b) + 128) >> 8) + 128);
+        v_plane[i] = static_cast<uint8_t>((((112 * r) - (94 * g) - (18 * b) + 128) >> 8) + 128);
+    }
+    out_ << "FRAME\n";
+    out_.write(reinterpret_cast<const char *>(planes_.data()), static_cast<std::streamsize>(planes_.size()));
+    if (!out_) {
+        throw std::runtime_error("Unable to write frame to " + path_ + ".");
+    }
+}
+
+void EpisodeRecorder::WritePPMFrame(const std::vector<uint8_t> &frame) {
+    constexpr std::size_t kMinDigits = 6;
+    const std::string index = std::to_string(num_frames_);
+    const std::string frame_path =
+        path_ + "_" + std::string(kMinDigits - std::min(kMinDigits, index.size()), '0') + index + ".ppm";
+    std::ofstream out(frame_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Unable to open " + frame_path + " for writing.");
+    }
+    const auto shape = renderer_.image_shape();
+    out << "P6\n" << shape[1] << " " << shape[0] << "\n255\n";
+    out.write(reinterpret_cast<const char *>(frame.data()), static_cast<std::streamsize>(frame.size()));
+    if (!out) {
+        throw std::runtime_error("Unable to write frame to " + frame_path + ".");
+    }
+}
+
+}    // namespace craftworld
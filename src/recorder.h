@@ -0,0 +1,78 @@
+#ifndef CRAFTWORLD_RECORDER_H_
+#define CRAFTWORLD_RECORDER_H_
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "craftworld_base.h"
+#include "render.h"
+
+namespace craftworld {
+
+// Container for recorded episodes
+enum class VideoFormat {
+    kY4M = 0,            // Single uncompressed YUV4MPEG2 (4:4:4) stream
+    kPPMSequence = 1,    // One binary PPM file per frame
+};
+
+/**
+ * Streams frames of a game state to disk as they are produced.
+ * Only the current frame is kept in memory, so the memory used does not grow with the episode length.
+ * @note The recorder holds a reference to the state, which must outlive the recorder
+ */
+class EpisodeRecorder {
+public:
+    /**
+     * @param state The state to record
+     * @param path Output file for kY4M, or path prefix for kPPMSequence (frames are written to path_000000.ppm, ...)
+     * @param format Container to write
+     * @param tile_size Width and height of each tile, one of kSupportedTileSizes
+     * @param fps Frame rate stored in the Y4M header
+     */
+    EpisodeRecorder(const CraftWorldGameState &state, std::string path, VideoFormat format = VideoFormat::kY4M,
+                    int tile_size = SPRITE_WIDTH, int fps = 10);
+    ~EpisodeRecorder();
+
+    EpisodeRecorder(const EpisodeRecorder &) = delete;
+    EpisodeRecorder(EpisodeRecorder &&) = delete;
+    auto operator=(const EpisodeRecorder &) -> EpisodeRecorder & = delete;
+    auto operator=(EpisodeRecorder &&) -> EpisodeRecorder & = delete;
+
+    /**
+     * Render the current state and append it as the next frame.
+     * @throw std::runtime_error if the frame cannot be written, or for kY4M if the frame size differs from the first
+     *        frame
+     */
+    void record();
+
+    /**
+     * Flush and close the output. Further calls to record() are invalid.
+     */
+    void close();
+
+    /**
+     * Get the number of frames written so far.
+     * @return number of frames
+     */
+    [[nodiscard]] auto num_frames() const noexcept -> std::size_t;
+
+private:
+    void WriteY4MFrame(const std::vector<uint8_t> &frame);
+    void WritePPMFrame(const std::vector<uint8_t> &frame);
+
+    Renderer renderer_;
+    std::string path_;
+    VideoFormat format_;
+    int fps_;
+    std::size_t num_frames_ = 0;
+    std::ofstream out_;
+    std::array<std::size_t, 3> y4m_shape_{};    // Image shape written to the Y4M header
+    std::vector<uint8_t> planes_;               // Reusable buffer for the YUV planes of a frame
+};
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_RECORDER_H_
@@ -0,0 +1,136 @@
+#include "render.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "sprite_atlas.h"
+
+namespace craftworld {
+
+Renderer::Renderer(const CraftWorldGameState &state, int tile_size, ImageFormat format)
+    : state_(&state), format_(format), atlas_(&get_sprite_atlas(tile_size, format)) {}
+
+auto Renderer::render() -> const std::vector<uint8_t> & {
+    const Board &board = state_->board;
+    if (!is_valid_ || rows_ != board.rows + 4 || cols_ != board.cols + 4) {
+        DrawFull();
+    } else {
+        DrawBoard();
+        DrawInventory();
+    }
+    return frame_;
+}
+
+auto Renderer::frame() const noexcept -> const std::vector<uint8_t> & {
+    return frame_;
+}
+
+auto Renderer::image_shape() const noexcept -> std::array<std::size_t, 3> {
+    return state_->image_shape(static_cast<int>(atlas_->tile_size()), format_);
+}
+
+void Renderer::invalidate() noexcept {
+    is_valid_ = false;
+}
+
+void Renderer::DrawFull() {
+    const Board &board = state_->board;
+    const auto tile_size = static_cast<int>(atlas_->tile_size());
+    const auto shape = state_->image_shape(tile_size, format_);
+    rows_ = board.rows + 4;
+    cols_ = board.cols + 4;
+    frame_.resize(shape[0] * shape[1] * shape[2]);
+    state_->render_into(frame_.data(), tile_size, format_);
+
+    // Remember what was drawn
+    board_ = board.grid;
+    inventory_slots_.resize(2 * cols_);
+    CollectInventorySlots(inventory_slots_);
+    is_valid_ = true;
+}
+
+void Renderer::DrawBoard() {
+    const Board &board = state_->board;
+    for (std::size_t i = 0; i < board.grid.size(); ++i) {
+        const Element el = board.grid[i];
+        if (board_[i] == el) {
+            continue;
+        }
+        board_[i] = el;
+        atlas_->blit(frame_.data(), el, (i / board.cols) + 2, (i % board.cols) + 2, cols_);
+    }
+}
+
+void Renderer::DrawInventory() {
+    slots_buffer_.resize(inventory_slots_.size());
+    CollectInventorySlots(slots_buffer_);
+    for (std::size_t slot = 0; slot < slots_buffer_.size(); ++slot) {
+        const int el = slots_buffer_[slot];
+        if (inventory_slots_[slot] == el) {
+            continue;
+        }
+        const std::size_t h = slot < cols_ ? 0 : rows_ - 1;
+        const std::size_t w = slot % cols_;
+        if (el == kNoSprite) {
+            atlas_->clear(frame_.data(), h, w, cols_);
+        } else {
+            atlas_->blit(frame_.data(), static_cast<Element>(el), h, w, cols_);
+        }
+    }
+    std::swap(inventory_slots_, slots_buffer_);
+}
+
+void Renderer::CollectInventorySlots(std::vector<int> &slots) const noexcept {
+    // Slots are filled in the same order as render_into(): top border row, then bottom border row
+    std::fill(slots.begin(), slots.end(), kNoSprite);
+    std::size_t inv_idx = 0;
+    for (const auto &[inv_item, inv_count] : state_->local_state.inventory) {
+        for (std::size_t i = 0; i < inv_count && inv_idx < slots.size(); ++i) {
+            slots[inv_idx++] = static_cast<int>(inv_item);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+BatchRenderer::BatchRenderer(std::size_t num_threads, int tile_size, ImageFormat format)
+    : tile_size_(tile_size), format_(format), pool_(num_threads) {
+    // Build the atlas up front so that rendering does not allocate
+    static_cast<void>(get_sprite_atlas(tile_size_, format_));
+}
+
+auto BatchRenderer::image_size(const CraftWorldGameState &state) const -> std::size_t {
+    const auto shape = state.image_shape(tile_size_, format_);
+    return shape[0] * shape[1] * shape[2];
+}
+
+void BatchRenderer::render(const std::vector<CraftWorldGameState> &states, uint8_t *out) {
+    if (states.empty()) {
+        return;
+    }
+    const std::size_t img_size = image_size(states[0]);
+    for (const auto &state : states) {
+        if (image_size(state) != img_size) {
+            throw std::invalid_argument("All states in a batch must have the same board dimensions.");
+        }
+    }
+    pool_.parallel_for(states.size(),
+                       [&](std::size_t i) { states[i].render_into(out + (i * img_size), tile_size_, format_); });
+}
+
+void BatchRenderer::render(const std::vector<const CraftWorldGameState *> &states, uint8_t *out) {
+    if (states.empty()) {
+        return;
+    }
+    const std::size_t img_size = image_size(*states[0]);
+    for (const auto &state : states) {
+        if (image_size(*state) != img_size) {
+            throw std::invalid_argument("All states in a batch must have the same board dimensions.");
+        }
+    }
+    pool_.parallel_for(states.size(),
+                       [&](std::size_t i) { states[i]->render_into(out + (i * img_size), tile_size_, format_); });
+}
+
+}    // namespace craftworld
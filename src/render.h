@@ -0,0 +1,120 @@
+#ifndef CRAFTWORLD_RENDER_H_
+#define CRAFTWORLD_RENDER_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "craftworld_base.h"
+#include "definitions.h"
+#include "thread_pool.h"
+
+namespace craftworld {
+
+class SpriteAtlas;
+
+/**
+ * Persistent renderer bound to a game state.
+ * The previous frame is kept, and each call to render() only redraws the board tiles and inventory slots which
+ * changed since the last frame. The output is identical to CraftWorldGameState::to_image(tile_size, format).
+ * @note The renderer holds a reference to the state, which must outlive the renderer
+ */
+class Renderer {
+public:
+    /**
+     * @param state The state to render
+     * @param tile_size Width and height of each tile, one of kSupportedTileSizes
+     * @param format Pixel format of the frames
+     */
+    explicit Renderer(const CraftWorldGameState &state, int tile_size = SPRITE_WIDTH,
+                      ImageFormat format = ImageFormat::kRGB);
+
+    /**
+     * Bring the frame up to date with the current state of the bound state.
+     * @return flat byte vector representing pixel values (HWC), valid until the next call to render()
+     */
+    auto render() -> const std::vector<uint8_t> &;
+
+    /**
+     * Get the most recently rendered frame without updating it.
+     * @return flat byte vector representing pixel values (HWC)
+     */
+    [[nodiscard]] auto frame() const noexcept -> const std::vector<uint8_t> &;
+
+    /**
+     * Get the shape the image should be viewed as.
+     * @return array indicating image HWC
+     */
+    [[nodiscard]] auto image_shape() const noexcept -> std::array<std::size_t, 3>;
+
+    /**
+     * Discard the previous frame, so that the next call to render() redraws every tile.
+     */
+    void invalidate() noexcept;
+
+private:
+    static constexpr int kNoSprite = -1;
+
+    void DrawFull();
+    void DrawBoard();
+    void DrawInventory();
+    void CollectInventorySlots(std::vector<int> &slots) const noexcept;
+
+    const CraftWorldGameState *state_;
+    ImageFormat format_;
+    const SpriteAtlas *atlas_;
+    std::size_t rows_ = 0;                // Tile rows of the frame, including border
+    std::size_t cols_ = 0;                // Tile columns of the frame, including border
+    bool is_valid_ = false;               // Previous frame is available
+    std::vector<uint8_t> frame_;          // Previous frame (HWC)
+    std::vector<Element> board_;          // Board grid drawn in the previous frame
+    std::vector<int> inventory_slots_;    // Element drawn at each inventory slot in the previous frame
+    std::vector<int> slots_buffer_;       // Reusable buffer for the current inventory slots
+};
+
+/**
+ * Renders batches of states into a single caller owned buffer (NHWC) using a pool of threads.
+ * No allocations are made while rendering.
+ */
+class BatchRenderer {
+public:
+    /**
+     * @param num_threads Number of threads used to render, including the calling thread
+     * @param tile_size Width and height of each tile, one of kSupportedTileSizes
+     * @param format Pixel format of the images
+     */
+    explicit BatchRenderer(std::size_t num_threads = std::thread::hardware_concurrency(),
+                           int tile_size = SPRITE_WIDTH, ImageFormat format = ImageFormat::kRGB);
+
+    /**
+     * Get the number of bytes of a single image in the batch.
+     * @param state State with the board dimensions used by the batch
+     * @return image size in bytes
+     */
+    [[nodiscard]] auto image_size(const CraftWorldGameState &state) const -> std::size_t;
+
+    /**
+     * Render each state into out, one image after another.
+     * @note All states must have the same board dimensions
+     * @param states States to render
+     * @param out Buffer holding at least states.size() * image_size() bytes
+     */
+    void render(const std::vector<CraftWorldGameState> &states, uint8_t *out);
+
+    /**
+     * Render each state into out, one image after another.
+     * @note All states must have the same board dimensions
+     * @param states States to render
+     * @param out Buffer holding at least states.size() * image_size() bytes
+     */
+    void render(const std::vector<const CraftWorldGameState *> &states, uint8_t *out);
+
+private:
+    int tile_size_;
+    ImageFormat format_;
+    ThreadPool pool_;
+};
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_RENDER_H_
@@ -0,0 +1,62 @@
+#ifndef CRAFTWORLD_SNAPSHOT_H_
+#define CRAFTWORLD_SNAPSHOT_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "definitions.h"
+
+namespace craftworld {
+
+// Magic number at the start of every state snapshot ("CWS1" in little-endian byte order)
+constexpr uint32_t kSnapshotMagic = 0x31535743;
+
+// How the grid bytes following the snapshot header are stored
+enum class SnapshotGridEncoding : uint8_t {
+    kRaw = 0,      // One byte per board cell
+    kDelta = 1,    // Cells which differ from the level's initial board, as (uint16 index, uint8 element) triplets
+};
+
+// Bytes per kDelta entry, a little-endian uint16 cell index followed by the element in that cell
+constexpr std::size_t kDeltaEntrySize = 3;
+
+/**
+ * Fixed-layout header of a state snapshot, followed by grid_size bytes of grid data.
+ * A snapshot only holds the mutable parts of a state, the level is referenced by its level id and resolved through
+ * a LevelRegistry on load. Fields are stored in native byte order.
+ */
+struct SnapshotHeader {
+    uint32_t magic = kSnapshotMagic;
+    uint16_t rows = 0;
+    uint16_t cols = 0;
+    uint64_t level_id = 0;
+    uint64_t zorb_hash = 0;
+    uint64_t reward_signal = 0;
+    uint32_t agent_idx = 0;
+    uint32_t grid_size = 0;                             // Number of grid bytes following the header
+    std::array<uint16_t, kNumElements> inventory{};    // Count of each element in the inventory
+    uint8_t current_reward = 0;
+    SnapshotGridEncoding grid_encoding = SnapshotGridEncoding::kRaw;
+    uint8_t goal = 0;                     // Goal element of the level
+    std::array<uint8_t, 7> reserved{};    // Unused, keeps the header free of padding
+};
+static_assert(std::is_trivially_copyable_v<SnapshotHeader>);
+static_assert(std::has_unique_object_representations_v<SnapshotHeader>, "SnapshotHeader must not contain padding");
+
+// Check that only inventory elements (kNumEnvironment onwards) have a non-zero count, as observations index their
+// inventory channels by element
+inline auto has_valid_inventory(const SnapshotHeader &header) noexcept -> bool {
+    for (std::size_t el = 0; el < header.inventory.size(); ++el) {
+        const bool is_inventory = el >= kNumEnvironment && el < kNumEnvironment + kNumInventory;
+        if (header.inventory[el] > 0 && !is_inventory) {    // NOLINT(*-constant-array-index)
+            return false;
+        }
+    }
+    return true;
+}
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_SNAPSHOT_H_
@@ -0,0 +1,264 @@
+#include "sprite_atlas.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace craftworld {
+
+// Spite assets
+#include "assets_all.inc"
+
+namespace {
+using Color = std::array<uint8_t, SPRITE_CHANNELS>;
+
+constexpr auto pack_color(const uint8_t *rgb) noexcept -> uint32_t {
+    return (static_cast<uint32_t>(rgb[0]) << 16) | (static_cast<uint32_t>(rgb[1]) << 8) | rgb[2];
+}
+
+constexpr auto unpack_color(uint32_t color) noexcept -> Color {
+    return {static_cast<uint8_t>(color >> 16), static_cast<uint8_t>(color >> 8), static_cast<uint8_t>(color)};
+}
+
+// BT.601 luma
+constexpr auto to_gray(const uint8_t *rgb) noexcept -> uint8_t {
+    return static_cast<uint8_t>(((299 * rgb[0]) + (587 * rgb[1]) + (114 * rgb[2]) + 500) / 1000);
+}
+
+struct ColorCount {
+    Color color;
+    std::size_t count;
+};
+
+// Weighted median cut over the colors of the full size sprites, with black reserved at index 0
+auto build_palette() -> std::vector<uint8_t> {
+    std::unordered_map<uint32_t, std::size_t> histogram;
+    for (const auto *sprite_data : img_asset_table) {
+        for (std::size_t i = 0; i < SPRITE_DATA_LEN; i += SPRITE_CHANNELS) {
+            ++histogram[pack_color(sprite_data + i)];
+        }
+    }
+    std::vector<ColorCount> colors;
+    colors.reserve(histogram.size());
+    for (const auto &[color, count] : histogram) {
+        colors.push_back({unpack_color(color), count});
+    }
+    // Deterministic starting order, independent of hash map iteration
+    std::sort(colors.begin(), colors.end(), [](const ColorCount &lhs, const ColorCount &rhs) {
+        return pack_color(lhs.color.data()) < pack_color(rhs.color.data());
+    });
+
+    // Boxes are [begin, end) ranges into colors
+    std::vector<std::pair<std::size_t, std::size_t>> boxes{{0, colors.size()}};
+    const auto channel_range = [&](const std::pair<std::size_t, std::size_t> &box, std::size_t ch) {
+        const auto [lo, hi] = std::minmax_element(
+            colors.begin() + static_cast<std::ptrdiff_t>(box.first), colors.begin() + static_cast<std::ptrdiff_t>(box.second),
+            [ch](const ColorCount &lhs, const ColorCount &rhs) { return lhs.color[ch] < rhs.color[ch]; });
+        return static_cast<int>(hi->color[ch]) - static_cast<int>(lo->color[ch]);
+    };
+    while (boxes.size() < kPaletteSize - 1) {
+        // Split the box with the widest channel range
+        std::size_t best_box = boxes.size();
+        std::size_t best_ch = 0;
+        int best_range = 0;
+        for (std::size_t b = 0; b < boxes.size(); ++b) {
+            if (boxes[b].second - boxes[b].first < 2) {
+                continue;
+            }
+            for (std::size_t ch = 0; ch < SPRITE_CHANNELS; ++ch) {
+                const int range = channel_range(boxes[b], ch);
+                if (range > best_range) {
+                    best_range = range;
+                    best_box = b;
+                    best_ch = ch;
+                }
+            }
+        }
+        if (best_box == boxes.size()) {
+            break;
+        }
+        auto &box = boxes[best_box];
+        const auto first = colors.begin() + static_cast<std::ptrdiff_t>(box.first);
+        const auto last = colors.begin() + static_cast<std::ptrdiff_t>(box.second);
+        std::stable_sort(first, last, [best_ch](const ColorCount &lhs, const ColorCount &rhs) {
+            return lhs.color[best_ch] < rhs.color[best_ch];
+        });
+        // Weighted median, keeping both halves non-empty
+        std::size_t total = 0;
+        for (auto it = first; it != last; ++it) {
+            total += it->count;
+        }
+        std::size_t split = box.first + 1;
+        for (std::size_t acc = colors[box.first].count; split < box.second - 1 && 2 * acc < total; ++split) {
+            acc += colors[split].count;
+        }
+        boxes.emplace_back(split, box.second);
+        box.second = split;
+    }
+
+    std::vector<uint8_t> palette(kPaletteSize * SPRITE_CHANNELS, 0);
+    for (std::size_t b = 0; b < boxes.size(); ++b) {
+        std::array<std::size_t, SPRITE_CHANNELS> sum{};
+        std::size_t total = 0;
+        for (std::size_t i = boxes[b].first; i < boxes[b].second; ++i) {
+            for (std::size_t ch = 0; ch < SPRITE_CHANNELS; ++ch) {
+                sum[ch] += colors[i].color[ch] * colors[i].count;
+            }
+            total += colors[i].count;
+        }
+        for (std::size_t ch = 0; ch < SPRITE_CHANNELS; ++ch) {
+            palette[((b + 1) * SPRITE_CHANNELS) + ch] = static_cast<uint8_t>((sum[ch] + total / 2) / total);
+        }
+    }
+    return palette;
+}
+
+// Index of the palette entry closest to the given color
+auto nearest_palette_index(const std::vector<uint8_t> &palette, const uint8_t *rgb) noexcept -> uint8_t {
+    std::size_t best_index = 0;
+    int best_dist = std::numeric_limits<int>::max();
+    for (std::size_t i = 0; i < kPaletteSize; ++i) {
+        int dist = 0;
+        for (std::size_t ch = 0; ch < SPRITE_CHANNELS; ++ch) {
+            const int diff = static_cast<int>(palette[(i * SPRITE_CHANNELS) + ch]) - static_cast<int>(rgb[ch]);
+            dist += diff * diff;
+        }
+        if (dist < best_dist) {
+            best_dist = dist;
+            best_index = i;
+        }
+    }
+    return static_cast<uint8_t>(best_index);
+}
+
+// Row copies with a compile time length, so that each memcpy is inlined
+template <std::size_t RowLen, std::size_t Rows>
+void blit_rows(uint8_t *dst, const uint8_t *src, std::size_t img_row_len) noexcept {
+    for (std::size_t r = 0; r < Rows; ++r) {
+        std::memcpy(dst, src, RowLen);
+        dst += img_row_len;
+        src += RowLen;
+    }
+}
+
+template <std::size_t TileSize>
+void blit_tile(uint8_t *dst, const uint8_t *src, std::size_t img_row_len, std::size_t channels) noexcept {
+    if (channels == 1) {
+        blit_rows<TileSize, TileSize>(dst, src, img_row_len);
+    } else {
+        blit_rows<TileSize * SPRITE_CHANNELS, TileSize>(dst, src, img_row_len);
+    }
+}
+}    // namespace
+
+SpriteAtlas::SpriteAtlas(int tile_size, ImageFormat format)
+    : tile_size_(static_cast<std::size_t>(tile_size)),
+      channels_(static_cast<std::size_t>(image_channels(format))),
+      row_len_(tile_size_ * channels_),
+      sprite_len_(tile_size_ * row_len_) {
+    if (!is_valid_tile_size(tile_size)) {
+        throw std::invalid_argument("Unsupported tile size.");
+    }
+    if (tile_size == SPRITE_WIDTH && format == ImageFormat::kRGB) {
+        sprites_ = img_asset_table;
+        return;
+    }
+
+    // The palette is built on first use, so only palette atlases pay for it
+    const std::vector<uint8_t> *palette = format == ImageFormat::kPalette ? &get_image_palette() : nullptr;
+    std::unordered_map<uint32_t, uint8_t> palette_lookup;    // Filled for palette atlases only
+    data_.resize(kNumElements * sprite_len_);
+    const std::size_t factor = SPRITE_WIDTH / tile_size_;
+    const std::size_t area = factor * factor;
+    for (std::size_t el = 0; el < kNumElements; ++el) {
+        const uint8_t *sprite_data = img_asset_table[el];
+        uint8_t *dst = data_.data() + (el * sprite_len_);
+        sprites_[el] = dst;
+        for (std::size_t r = 0; r < tile_size_; ++r) {
+            for (std::size_t c = 0; c < tile_size_; ++c) {
+                // Box filter the sprite down to the tile size
+                Color rgb{};
+                for (std::size_t ch = 0; ch < SPRITE_CHANNELS; ++ch) {
+                    std::size_t sum = 0;
+                    for (std::size_t dr = 0; dr < factor; ++dr) {
+                        for (std::size_t dc = 0; dc < factor; ++dc) {
+                            sum += sprite_data[((r * factor + dr) * SPRITE_DATA_LEN_PER_ROW) +
+                                               ((c * factor + dc) * SPRITE_CHANNELS) + ch];
+                        }
+                    }
+                    rgb[ch] = static_cast<uint8_t>((sum + area / 2) / area);
+                }
+
+                uint8_t *pixel = dst + (r * row_len_) + (c * channels_);
+                switch (format) {
+                    case ImageFormat::kRGB:
+                        std::copy(rgb.begin(), rgb.end(), pixel);
+                        break;
+                    case ImageFormat::kPalette: {
+                        const auto [it, is_new] = palette_lookup.try_emplace(pack_color(rgb.data()), 0);
+                        if (is_new) {
+                            it->second = nearest_palette_index(*palette, rgb.data());
+                        }
+                        *pixel = it->second;
+                        break;
+                    }
+                    case ImageFormat::kGrayscale:
+                        *pixel = to_gray(rgb.data());
+                        break;
+                }
+            }
+        }
+    }
+}
+
+void SpriteAtlas::blit(uint8_t *img, Element element, std::size_t h, std::size_t w, std::size_t cols) const noexcept {
+    const std::size_t img_row_len = row_len_ * cols;
+    const uint8_t *src = sprite(element);
+    uint8_t *dst = img + (h * sprite_len_ * cols) + (w * row_len_);
+    switch (tile_size_) {
+        case 8:
+            blit_tile<8>(dst, src, img_row_len, channels_);
+            break;
+        case 16:
+            blit_tile<16>(dst, src, img_row_len, channels_);
+            break;
+        default:
+            blit_tile<SPRITE_WIDTH>(dst, src, img_row_len, channels_);
+            break;
+    }
+}
+
+void SpriteAtlas::clear(uint8_t *img, std::size_t h, std::size_t w, std::size_t cols) const noexcept {
+    const std::size_t img_row_len = row_len_ * cols;
+    uint8_t *dst = img + (h * sprite_len_ * cols) + (w * row_len_);
+    for (std::size_t r = 0; r < tile_size_; ++r) {
+        std::memset(dst, 0, row_len_);
+        dst += img_row_len;
+    }
+}
+
+auto get_sprite_atlas(int tile_size, ImageFormat format) -> const SpriteAtlas & {
+    constexpr std::size_t kNumFormats = 3;
+    static std::array<std::once_flag, kSupportedTileSizes.size() * kNumFormats> flags;
+    static std::array<std::unique_ptr<const SpriteAtlas>, kSupportedTileSizes.size() * kNumFormats> atlases;
+
+    const auto tile_it = std::find(kSupportedTileSizes.begin(), kSupportedTileSizes.end(), tile_size);
+    if (tile_it == kSupportedTileSizes.end()) {
+        throw std::invalid_argument("Unsupported tile size.");
+    }
+    const auto idx = (static_cast<std::size_t>(tile_it - kSupportedTileSizes.begin()) * kNumFormats) +
+                     static_cast<std::size_t>(format);
+    std::call_once(flags[idx], [&]() { atlases[idx] = std::make_unique<const SpriteAtlas>(tile_size, format); });
+    return *atlases[idx];
+}
+
+auto get_image_palette() -> const std::vector<uint8_t> & {
+    static const std::vector<uint8_t> palette = build_palette();
+    return palette;
+}
+
+}    // namespace craftworld
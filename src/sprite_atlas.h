@@ -0,0 +1,80 @@
+#ifndef CRAFTWORLD_SPRITE_ATLAS_H_
+#define CRAFTWORLD_SPRITE_ATLAS_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "craftworld_base.h"
+#include "definitions.h"
+
+namespace craftworld {
+
+// Sprite data for every element, indexed by element
+class SpriteAtlas {
+public:
+    /**
+     * Build the atlas from the embedded sprite assets, downsampled to the given tile size and converted to the given
+     * format. The full size RGB atlas refers to the embedded read-only assets directly.
+     * @param tile_size Width and height of each tile, one of kSupportedTileSizes
+     * @param format Pixel format of the sprites
+     */
+    SpriteAtlas(int tile_size, ImageFormat format);
+
+    [[nodiscard]] auto tile_size() const noexcept -> std::size_t {
+        return tile_size_;
+    }
+
+    // Bytes per sprite
+    [[nodiscard]] auto sprite_len() const noexcept -> std::size_t {
+        return sprite_len_;
+    }
+
+    /**
+     * Get the sprite data (HWC) for the given element.
+     * @param element Element to query
+     * @return pointer to the first byte of the sprite
+     */
+    [[nodiscard]] auto sprite(Element element) const noexcept -> const uint8_t * {
+        return sprites_[static_cast<std::size_t>(element)];
+    }
+
+    /**
+     * Copy the sprite of an element into a tile of an image using one memcpy per sprite row.
+     * @param img Image data (HWC)
+     * @param element Element to draw
+     * @param h Tile row
+     * @param w Tile column
+     * @param cols Number of tile columns in the image
+     */
+    void blit(uint8_t *img, Element element, std::size_t h, std::size_t w, std::size_t cols) const noexcept;
+
+    /**
+     * Clear a tile of an image to black.
+     * @param img Image data (HWC)
+     * @param h Tile row
+     * @param w Tile column
+     * @param cols Number of tile columns in the image
+     */
+    void clear(uint8_t *img, std::size_t h, std::size_t w, std::size_t cols) const noexcept;
+
+private:
+    std::size_t tile_size_;
+    std::size_t channels_;
+    std::size_t row_len_;       // Bytes per sprite row
+    std::size_t sprite_len_;    // Bytes per sprite
+    std::array<const uint8_t *, kNumElements> sprites_{};
+    std::vector<uint8_t> data_;    // Converted sprites, contiguous by element
+};
+
+/**
+ * Get the atlas of the embedded sprite assets for the given tile size and format, built on first use.
+ * @param tile_size Width and height of each tile, one of kSupportedTileSizes
+ * @param format Pixel format of the sprites
+ * @return sprite atlas
+ */
+auto get_sprite_atlas(int tile_size, ImageFormat format = ImageFormat::kRGB) -> const SpriteAtlas &;
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_SPRITE_ATLAS_H_
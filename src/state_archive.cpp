@@ -0,0 +1,258 @@
+#include "state_archive.h"
+
+#include <array>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include "compression.h"
+#include "level_registry.h"
+
+namespace craftworld {
+
+namespace {
+// Records and the index are aligned to this many bytes
+constexpr std::size_t kRecordAlignment = 8;
+
+constexpr std::array<uint8_t, kRecordAlignment> kPadding{};
+
+// ArchiveHeader flags
+constexpr uint32_t kCompressedFlag = 1U;
+
+struct ArchiveHeader {
+    uint32_t magic = kArchiveMagic;
+    uint32_t version = kArchiveVersion;
+    uint32_t flags = 0;
+    uint32_t reserved = 0;
+};
+
+struct ArchiveFooter {
+    uint64_t num_records = 0;
+    uint64_t index_offset = 0;          // Offset of the record index from the start of the file
+    uint64_t level_table_offset = 0;    // Offset of the level table from the start of the file
+    uint64_t num_levels = 0;
+    uint32_t version = kArchiveVersion;
+    uint32_t magic = kArchiveMagic;
+};
+
+static_assert(sizeof(ArchiveHeader) % kRecordAlignment == 0);
+static_assert(std::has_unique_object_representations_v<ArchiveHeader>);
+static_assert(std::has_unique_object_representations_v<ArchiveFooter>);
+
+auto get_bytes(const uint8_t *&data, const uint8_t *end, std::size_t size) -> const uint8_t * {
+    if (static_cast<std::size_t>(end - data) < size) {
+        throw std::invalid_argument("Level table is truncated.");
+    }
+    const uint8_t *bytes = data;
+    data += size;
+    return bytes;
+}
+}    // namespace
+
+StateArchiveWriter::StateArchiveWriter(std::string path, SnapshotGridEncoding encoding, bool compress)
+    : path_(std::move(path)), encoding_(encoding), compress_(compress) {
+    out_.open(path_, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        throw std::runtime_error("Unable to open " + path_ + " for writing.");
+    }
+    ArchiveHeader header;
+    header.flags = compress_ ? kCompressedFlag : 0;
+    Write(&header, sizeof(header));
+}
+
+StateArchiveWriter::~StateArchiveWriter() {
+    if (out_.is_open()) {
+        try {
+            close();
+        } catch (...) {    // NOLINT(bugprone-empty-catch)
+            // Destructor must not throw, call close() to observe write errors
+        }
+    }
+}
+
+auto StateArchiveWriter::append(const CraftWorldGameState &state) -> std::size_t {
+    if (levels_.count(state.level_id()) == 0) {
+        levels_.emplace(state.level_id(), state.shared_state());
+    }
+    buffer_.resize(state.snapshot_size(encoding_));
+    state.snapshot_into(buffer_.data(), buffer_.size(), encoding_);
+    return append(buffer_.data(), buffer_.size());
+}
+
+auto StateArchiveWriter::append(const uint8_t *snapshot, std::size_t size) -> std::size_t {
+    SnapshotHeader header;
+    if (size < sizeof(header)) {
+        throw std::invalid_argument("Snapshot is too small.");
+    }
+    std::memcpy(&header, snapshot, sizeof(header));
+    if (levels_.count(header.level_id) == 0) {
+        auto level = LevelRegistry::instance().find(header.level_id);
+        if (!level) {
+            throw std::invalid_argument("Snapshot references a level which is not registered.");
+        }
+        levels_.emplace(header.level_id, std::move(level));
+    }
+    if (compress_) {
+        // Each record is compressed on its own, so records can still be read in any order
+        compressed_.clear();
+        compress_snapshot(snapshot, size, compressed_);
+        snapshot = compressed_.data();
+        size = compressed_.size();
+    }
+    offsets_.push_back(offset_);
+    Write(snapshot, size);
+    Write(kPadding.data(), (kRecordAlignment - (size % kRecordAlignment)) % kRecordAlignment);
+    return offsets_.size() - 1;
+}
+
+void StateArchiveWriter::close() {
+    if (!out_.is_open()) {
+        return;
+    }
+    ArchiveFooter footer;
+    footer.num_records = offsets_.size();
+    footer.level_table_offset = offset_;
+    footer.num_levels = levels_.size();
+    // Level table, so the archive can be read without registering its levels first
+    std::vector<uint8_t> table;
+    for (const auto &[level_id, level] : levels_) {
+        const std::size_t pos = table.size();
+        table.resize(pos + sizeof(level_id));
+        std::memcpy(table.data() + pos, &level_id, sizeof(level_id));
+        table.push_back(static_cast<uint8_t>(level->workshop_swap));
+        put_varint(level->game_board_str.size(), table);
+        table.insert(table.end(), level->game_board_str.begin(), level->game_board_str.end());
+    }
+    Write(table.data(), table.size());
+    Write(kPadding.data(), (kRecordAlignment - (table.size() % kRecordAlignment)) % kRecordAlignment);
+    footer.index_offset = offset_;
+    offsets_.push_back(footer.level_table_offset);
+    Write(offsets_.data(), offsets_.size() * sizeof(uint64_t));
+    Write(&footer, sizeof(footer));
+    offsets_.pop_back();
+    out_.close();
+    if (!out_) {
+        throw std::runtime_error("Unable to write archive to " + path_ + ".");
+    }
+}
+
+auto StateArchiveWriter::size() const noexcept -> std::size_t {
+    return offsets_.size();
+}
+
+void StateArchiveWriter::Write(const void *data, std::size_t size) {
+    out_.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    if (!out_) {
+        throw std::runtime_error("Unable to write archive to " + path_ + ".");
+    }
+    offset_ += size;
+}
+
+// ---------------------------------------------------------------------------
+
+StateArchive::StateArchive(const std::string &path) : file_(path) {
+    ArchiveHeader header;
+    ArchiveFooter footer;
+    if (file_.size() < sizeof(header) + sizeof(footer)) {
+        throw std::runtime_error(path + " is not a state archive.");
+    }
+    std::memcpy(&header, file_.data(), sizeof(header));
+    std::memcpy(&footer, file_.data() + file_.size() - sizeof(footer), sizeof(footer));
+    if (header.magic != kArchiveMagic || footer.magic != kArchiveMagic) {
+        throw std::runtime_error(path + " is not a state archive, or was not closed.");
+    }
+    if (header.version != kArchiveVersion || footer.version != kArchiveVersion) {
+        throw std::runtime_error(path + " has an unsupported archive version.");
+    }
+    // The index holds num_records + 1 offsets between the header and footer, checked before computing its size so a
+    // corrupt record count cannot overflow it
+    const uint64_t max_index_entries = (file_.size() - sizeof(header) - sizeof(footer)) / sizeof(uint64_t);
+    if (footer.num_records >= max_index_entries) {
+        throw std::runtime_error(path + " has a corrupt archive index.");
+    }
+    const uint64_t index_size = (footer.num_records + 1) * sizeof(uint64_t);
+    if (footer.index_offset < sizeof(header) || footer.index_offset != file_.size() - sizeof(footer) - index_size ||
+        footer.level_table_offset < sizeof(header) || footer.level_table_offset > footer.index_offset) {
+        throw std::runtime_error(path + " has a corrupt archive index.");
+    }
+    index_ = file_.data() + footer.index_offset;
+    records_end_ = footer.level_table_offset;
+    size_ = static_cast<std::size_t>(footer.num_records);
+    compressed_ = (header.flags & kCompressedFlag) != 0;
+
+    // Levels are registered while the archive is open, so the states of its records can be constructed
+    const uint8_t *pos = file_.data() + footer.level_table_offset;
+    const uint8_t *end = index_;
+    try {
+        for (uint64_t i = 0; i < footer.num_levels; ++i) {
+            uint64_t level_id = 0;
+            std::memcpy(&level_id, get_bytes(pos, end, sizeof(level_id)), sizeof(level_id));
+            const bool workshop_swap = *get_bytes(pos, end, 1) != 0;
+            const auto length = static_cast<std::size_t>(get_varint(pos, end));
+            const auto *board = reinterpret_cast<const char *>(get_bytes(pos, end, length));    // NOLINT
+            auto level = LevelRegistry::instance().add(std::string(board, length), workshop_swap);
+            if (level->level_id != level_id) {
+                throw std::invalid_argument("Level id does not match its board.");
+            }
+            levels_.push_back(std::move(level));
+        }
+    } catch (const std::exception &e) {
+        throw std::runtime_error(path + " has a corrupt level table: " + e.what());
+    }
+}
+
+auto StateArchive::Offset(std::size_t index) const noexcept -> uint64_t {
+    uint64_t offset = 0;
+    std::memcpy(&offset, index_ + (index * sizeof(uint64_t)), sizeof(offset));
+    return offset;
+}
+
+auto StateArchive::data(std::size_t index) const noexcept -> const uint8_t * {
+    return file_.data() + Offset(index);
+}
+
+auto StateArchive::record_size(std::size_t index) const noexcept -> std::size_t {
+    return static_cast<std::size_t>(Offset(index + 1) - Offset(index));
+}
+
+void StateArchive::CheckRecord(std::size_t index) const {
+    if (index >= size_) {
+        throw std::out_of_range("Archive record index out of range.");
+    }
+    // Offsets are checked on access, so opening an archive does not need to read the whole index
+    const uint64_t begin = Offset(index);
+    const uint64_t end = Offset(index + 1);
+    if (begin < sizeof(ArchiveHeader) || begin > end || end > records_end_) {
+        throw std::runtime_error("Corrupt archive index.");
+    }
+}
+
+auto StateArchive::view(std::size_t index) const -> StateView {
+    CheckRecord(index);
+    if (compressed_) {
+        throw std::runtime_error("Records of a compressed archive cannot be viewed in place, use snapshot().");
+    }
+    return {data(index), record_size(index)};
+}
+
+void StateArchive::snapshot(std::size_t index, std::vector<uint8_t> &snapshot) const {
+    CheckRecord(index);
+    if (compressed_) {
+        decompress_snapshot(data(index), record_size(index), snapshot);
+    } else {
+        snapshot.assign(data(index), data(index) + record_size(index));
+    }
+}
+
+auto StateArchive::state(std::size_t index) const -> CraftWorldGameState {
+    CheckRecord(index);
+    if (compressed_) {
+        thread_local std::vector<uint8_t> buffer;
+        decompress_snapshot(data(index), record_size(index), buffer);
+        return CraftWorldGameState::from_snapshot(buffer.data(), buffer.size());
+    }
+    return CraftWorldGameState::from_snapshot(data(index), record_size(index));
+}
+
+}    // namespace craftworld
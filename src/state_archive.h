@@ -0,0 +1,212 @@
+#ifndef CRAFTWORLD_STATE_ARCHIVE_H_
+#define CRAFTWORLD_STATE_ARCHIVE_H_
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "craftworld_base.h"
+#include "mapped_file.h"
+#include "snapshot.h"
+#include "state_view.h"
+
+namespace craftworld {
+
+// Magic number at the start and end of every state archive ("CWSA" in little-endian byte order)
+constexpr uint32_t kArchiveMagic = 0x41535743;
+constexpr uint32_t kArchiveVersion = 2;
+
+/**
+ * Append-only writer of a state archive.
+ * An archive is a file header, followed by one state snapshot per record (each padded to 8 bytes), a table with the
+ * board string of every level referenced by the records, an index of record offsets and a footer. The level table and
+ * index are written by close(), so an archive is only readable once closed.
+ */
+class StateArchiveWriter {
+public:
+    /**
+     * @param path Archive file to create, an existing file is overwritten
+     * @param encoding How the board grid of each snapshot is stored
+     * @param compress Compress each record with compress_snapshot(), records stay independently readable
+     * @throw std::runtime_error if the file cannot be opened
+     */
+    explicit StateArchiveWriter(std::string path, SnapshotGridEncoding encoding = SnapshotGridEncoding::kRaw,
+                                bool compress = false);
+    ~StateArchiveWriter();
+
+    StateArchiveWriter(const StateArchiveWriter &) = delete;
+    StateArchiveWriter(StateArchiveWriter &&) = delete;
+    auto operator=(const StateArchiveWriter &) -> StateArchiveWriter & = delete;
+    auto operator=(StateArchiveWriter &&) -> StateArchiveWriter & = delete;
+
+    /**
+     * Append a snapshot of the state as the next record.
+     * @param state State to store
+     * @return index of the record
+     */
+    auto append(const CraftWorldGameState &state) -> std::size_t;
+
+    /**
+     * Append an existing snapshot as the next record.
+     * @param snapshot Pointer to the snapshot bytes
+     * @param size Number of snapshot bytes
+     * @return index of the record
+     * @throw std::invalid_argument if the snapshot is too small, or its level is not registered so it cannot be added
+     *        to the level table
+     */
+    auto append(const uint8_t *snapshot, std::size_t size) -> std::size_t;
+
+    /**
+     * Write the index and footer, and close the file. Further calls to append() are invalid.
+     * @throw std::runtime_error if writing fails
+     */
+    void close();
+
+    /**
+     * Get the number of records appended so far.
+     * @return number of records
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+private:
+    void Write(const void *data, std::size_t size);
+
+    std::string path_;
+    SnapshotGridEncoding encoding_;
+    bool compress_;
+    std::ofstream out_;
+    std::vector<uint64_t> offsets_;      // Offset of each record from the start of the file
+    uint64_t offset_ = 0;                // Current end of the file
+    std::vector<uint8_t> buffer_;        // Reusable buffer for snapshots
+    std::vector<uint8_t> compressed_;    // Reusable buffer for compressed snapshots
+    // Levels referenced by the records, written to the level table in level id order
+    std::map<uint64_t, std::shared_ptr<const SharedStateInfo>> levels_;
+};
+
+/**
+ * Memory mapped, read-only state archive written by StateArchiveWriter.
+ * Opening an archive maps the file, checks its footer and registers the levels of its level table, which are kept
+ * alive while the archive is open. Records are accessed in O(1) through the index.
+ * All methods are const, so one archive can be read from multiple threads.
+ */
+class StateArchive {
+public:
+    /**
+     * @param path Archive file to open
+     * @throw std::runtime_error if the file cannot be opened, is not a valid archive, or a level of its level table
+     *        collides with a different registered level
+     */
+    explicit StateArchive(const std::string &path);
+
+    /**
+     * Get the number of records in the archive.
+     * @return number of records
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+        return size_;
+    }
+
+    /**
+     * Check if the records are compressed, in which case they must be read with snapshot() or state().
+     * @return true if the archive was written with compression
+     */
+    [[nodiscard]] auto compressed() const noexcept -> bool {
+        return compressed_;
+    }
+
+    /**
+     * Get a pointer to the bytes of a record, which are compressed if compressed() is true.
+     * @param index Record index, less than size()
+     * @return pointer into the mapped file
+     */
+    [[nodiscard]] auto data(std::size_t index) const noexcept -> const uint8_t *;
+
+    /**
+     * Get the number of bytes of a record, including its padding.
+     * @param index Record index, less than size()
+     * @return record size in bytes
+     */
+    [[nodiscard]] auto record_size(std::size_t index) const noexcept -> std::size_t;
+
+    /**
+     * Get a read-only view of a record, without constructing a state.
+     * @param index Record index
+     * @return view into the mapped file
+     * @throw std::out_of_range if index is not less than size()
+     * @throw std::runtime_error if the archive is compressed
+     */
+    [[nodiscard]] auto view(std::size_t index) const -> StateView;
+
+    /**
+     * Copy the snapshot of a record, decompressing it if needed.
+     * @param index Record index
+     * @param snapshot Vector to store the snapshot in
+     * @throw std::out_of_range if index is not less than size()
+     */
+    void snapshot(std::size_t index, std::vector<uint8_t> &snapshot) const;
+
+    /**
+     * Construct the state of a record. Its level is registered by the archive, so no other owner is needed.
+     * @param index Record index
+     * @return state
+     * @throw std::out_of_range if index is not less than size()
+     * @throw std::invalid_argument if the record is malformed
+     */
+    [[nodiscard]] auto state(std::size_t index) const -> CraftWorldGameState;
+
+    // Iterates over the views of all records
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = StateView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = StateView;
+
+        Iterator(const StateArchive *archive, std::size_t index) noexcept : archive_(archive), index_(index) {}
+
+        auto operator*() const -> StateView {
+            return archive_->view(index_);
+        }
+        auto operator++() noexcept -> Iterator & {
+            ++index_;
+            return *this;
+        }
+        auto operator==(const Iterator &other) const noexcept -> bool {
+            return index_ == other.index_;
+        }
+        auto operator!=(const Iterator &other) const noexcept -> bool {
+            return index_ != other.index_;
+        }
+
+    private:
+        const StateArchive *archive_;
+        std::size_t index_;
+    };
+
+    [[nodiscard]] auto begin() const noexcept -> Iterator {
+        return {this, 0};
+    }
+    [[nodiscard]] auto end() const noexcept -> Iterator {
+        return {this, size_};
+    }
+
+private:
+    [[nodiscard]] auto Offset(std::size_t index) const noexcept -> uint64_t;
+    void CheckRecord(std::size_t index) const;
+
+    MappedFile file_;
+    const uint8_t *index_ = nullptr;    // size_ + 1 record offsets, the last one is the end of the records
+    uint64_t records_end_ = 0;          // Offset of the level table, which follows the records
+    std::vector<std::shared_ptr<const SharedStateInfo>> levels_;    // Levels of the level table
+    std::size_t size_ = 0;
+    bool compressed_ = false;
+};
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_STATE_ARCHIVE_H_
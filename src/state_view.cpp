@@ -0,0 +1,124 @@
+#include "state_view.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "observation.h"
+
+namespace craftworld {
+
+namespace {
+// Observation source over the snapshot bytes, see observation.h
+class SnapshotSource {
+public:
+    SnapshotSource(const SnapshotHeader &header, const uint8_t *grid) noexcept : header_(header), grid_(grid) {}
+
+    [[nodiscard]] auto rows() const noexcept -> std::size_t {
+        return header_.rows;
+    }
+    [[nodiscard]] auto cols() const noexcept -> std::size_t {
+        return header_.cols;
+    }
+    [[nodiscard]] auto cell(std::size_t index) const noexcept -> Element {
+        return static_cast<Element>(grid_[index]);
+    }
+    [[nodiscard]] auto goal() const noexcept -> Element {
+        return static_cast<Element>(header_.goal);
+    }
+    template <typename F>
+    void for_each_inventory(F &&f) const {
+        for (std::size_t el = 0; el < kNumElements; ++el) {
+            const uint16_t count = header_.inventory[el];    // NOLINT(*-constant-array-index)
+            if (count > 0) {
+                f(static_cast<Element>(el), static_cast<std::size_t>(count));
+            }
+        }
+    }
+
+private:
+    const SnapshotHeader &header_;
+    const uint8_t *grid_;
+};
+}    // namespace
+
+StateView::StateView(const uint8_t *data, std::size_t size) {
+    if (size < sizeof(header_)) {
+        throw std::invalid_argument("Snapshot is too small.");
+    }
+    std::memcpy(&header_, data, sizeof(header_));
+    const std::size_t board_size = static_cast<std::size_t>(header_.rows) * header_.cols;
+    if (header_.magic != kSnapshotMagic || size < sizeof(header_) + header_.grid_size ||
+        header_.agent_idx >= board_size || header_.goal < kPrimitiveStart ||
+        header_.goal >= kPrimitiveStart + kNumPrimitive + kNumRecipeTypes) {
+        throw std::invalid_argument("Invalid snapshot header.");
+    }
+    if (!has_valid_inventory(header_)) {
+        throw std::invalid_argument("Invalid inventory element in snapshot.");
+    }
+    if (has_board() && header_.grid_size != board_size) {
+        throw std::invalid_argument("Snapshot size does not match its board dimensions.");
+    }
+    grid_ = data + sizeof(header_);
+}
+
+auto StateView::check_inventory(Element element) const -> int {
+    if (static_cast<int>(element) < 0 || static_cast<int>(element) >= kNumElements) {
+        throw std::invalid_argument("Unknown element type.");
+    }
+    return header_.inventory[static_cast<std::size_t>(element)];    // NOLINT(*-constant-array-index)
+}
+
+auto StateView::is_solution() const noexcept -> bool {
+    // Inventory contains the goal item
+    return header_.inventory[header_.goal] > 0;    // NOLINT(*-constant-array-index)
+}
+
+auto StateView::observation_shape(ObservationType obs_type, ObservationLayout layout) const noexcept
+    -> std::array<int, 3> {
+    return make_observation_shape(static_cast<int>(observation_channels(obs_type)), header_.rows, header_.cols,
+                                  layout);
+}
+
+auto StateView::observation_size(ObservationType obs_type) const noexcept -> std::size_t {
+    return observation_channels(obs_type) * header_.rows * header_.cols;
+}
+
+void StateView::get_observation(float *obs, ObservationType obs_type, ObservationLayout layout) const {
+    WriteObservation(obs, obs_type, layout);
+}
+
+void StateView::get_observation(Float16 *obs, ObservationType obs_type, ObservationLayout layout) const {
+    WriteObservation(obs, obs_type, layout);
+}
+
+void StateView::get_observation(BFloat16 *obs, ObservationType obs_type, ObservationLayout layout) const {
+    WriteObservation(obs, obs_type, layout);
+}
+
+template <typename T>
+void StateView::WriteObservation(T *obs, ObservationType obs_type, ObservationLayout layout) const {
+    if (!has_board()) {
+        throw std::invalid_argument("Observations require a snapshot holding the full board.");
+    }
+    // Grid is only validated here, so queries which don't need the board never touch it
+    const std::size_t board_size = static_cast<std::size_t>(header_.rows) * header_.cols;
+    for (std::size_t i = 0; i < board_size; ++i) {
+        if (grid_[i] >= kNumElements) {
+            throw std::invalid_argument("Unknown element type in snapshot.");
+        }
+    }
+    const SnapshotSource source(header_, grid_);
+    switch (obs_type) {
+        case ObservationType::kFull:
+            write_observation(obs, source, layout);
+            break;
+        case ObservationType::kBinary:
+            write_binary_observation(obs, source, layout);
+            break;
+        case ObservationType::kEnvironment:
+            write_environment_observation(obs, source, layout);
+            break;
+    }
+}
+
+}    // namespace craftworld
@@ -0,0 +1,131 @@
+#ifndef CRAFTWORLD_STATE_VIEW_H_
+#define CRAFTWORLD_STATE_VIEW_H_
+
+#include <array>
+#include <cstdint>
+
+#include "definitions.h"
+#include "half.h"
+#include "snapshot.h"
+
+namespace craftworld {
+
+/**
+ * Read-only view of a state snapshot (see CraftWorldGameState::snapshot()), which answers queries directly from the
+ * snapshot bytes without constructing a state or resolving its level.
+ * @note The view does not own the bytes, which must outlive the view
+ */
+class StateView {
+public:
+    /**
+     * @param data Pointer to the snapshot bytes
+     * @param size Number of snapshot bytes
+     * @throw std::invalid_argument if the snapshot is malformed
+     */
+    StateView(const uint8_t *data, std::size_t size);
+
+    /**
+     * Get the id of the level the state belongs to.
+     * @return level id
+     */
+    [[nodiscard]] auto level_id() const noexcept -> uint64_t {
+        return header_.level_id;
+    }
+
+    /**
+     * Get the hash representation for the state.
+     * @return hash value
+     */
+    [[nodiscard]] auto get_hash() const noexcept -> uint64_t {
+        return header_.zorb_hash;
+    }
+
+    /**
+     * Get the reward signal as a result of the action which led to the state.
+     * @return bit field representing events that occured
+     */
+    [[nodiscard]] auto get_reward_signal() const noexcept -> uint64_t {
+        return header_.reward_signal;
+    }
+
+    /**
+     * Get the agent index position, even if in exit
+     * @return Agent index
+     */
+    [[nodiscard]] auto get_agent_index() const noexcept -> std::size_t {
+        return header_.agent_idx;
+    }
+
+    /**
+     * Get the goal element of the level.
+     * @return goal element
+     */
+    [[nodiscard]] auto goal() const noexcept -> Element {
+        return static_cast<Element>(header_.goal);
+    }
+
+    /**
+     * Get the query element count in the inventory
+     * @param element Element to query
+     * @return element count in inventory
+     */
+    [[nodiscard]] auto check_inventory(Element element) const -> int;
+
+    /**
+     * Check if the state is in the solution state (goal item in the inventory).
+     * @return True if terminal, false otherwise
+     */
+    [[nodiscard]] auto is_solution() const noexcept -> bool;
+
+    /**
+     * Check if the snapshot holds the full board, which the observation writers require.
+     * @return True if the board grid is stored with SnapshotGridEncoding::kRaw
+     */
+    [[nodiscard]] auto has_board() const noexcept -> bool {
+        return header_.grid_encoding == SnapshotGridEncoding::kRaw;
+    }
+
+    /**
+     * Get the shape the observations should be viewed as.
+     * @param obs_type Kind of observation
+     * @param layout Memory layout of the observation
+     * @return array indicating observation shape in the given layout (CHW or HWC)
+     */
+    [[nodiscard]] auto observation_shape(ObservationType obs_type = ObservationType::kFull,
+                                         ObservationLayout layout = ObservationLayout::kCHW) const noexcept
+        -> std::array<int, 3>;
+
+    /**
+     * Get the number of elements in a flat observation of the given type.
+     * @param obs_type Kind of observation
+     * @return number of elements
+     */
+    [[nodiscard]] auto observation_size(ObservationType obs_type = ObservationType::kFull) const noexcept
+        -> std::size_t;
+
+    /**
+     * Write the observation of the state into the given buffer, identical to the corresponding
+     * CraftWorldGameState observation.
+     * @param obs Buffer holding at least observation_size(obs_type) elements
+     * @param obs_type Kind of observation
+     * @param layout Memory layout of the observation
+     * @throw std::invalid_argument if the snapshot does not hold the full board
+     */
+    void get_observation(float *obs, ObservationType obs_type = ObservationType::kFull,
+                         ObservationLayout layout = ObservationLayout::kCHW) const;
+    void get_observation(Float16 *obs, ObservationType obs_type = ObservationType::kFull,
+                         ObservationLayout layout = ObservationLayout::kCHW) const;
+    void get_observation(BFloat16 *obs, ObservationType obs_type = ObservationType::kFull,
+                         ObservationLayout layout = ObservationLayout::kCHW) const;
+
+private:
+    template <typename T>
+    void WriteObservation(T *obs, ObservationType obs_type, ObservationLayout layout) const;
+
+    SnapshotHeader header_;
+    const uint8_t *grid_;
+};
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_STATE_VIEW_H_
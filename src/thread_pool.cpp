@@ -0,0 +1,80 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace craftworld {
+
+ThreadPool::ThreadPool(std::size_t num_threads) {
+    num_threads = std::max<std::size_t>(num_threads, 1);
+    workers_.reserve(num_threads - 1);
+    for (std::size_t i = 0; i < num_threads - 1; ++i) {
+        workers_.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+auto ThreadPool::num_threads() const noexcept -> std::size_t {
+    return workers_.size() + 1;
+}
+
+void ThreadPool::Run(std::size_t n, InvokeFn invoke, void *ctx) {
+    if (workers_.empty() || n <= 1) {
+        for (std::size_t i = 0; i < n; ++i) {
+            invoke(ctx, i);
+        }
+        return;
+    }
+
+    const std::lock_guard<std::mutex> run_lock(run_mutex_);
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        invoke_ = invoke;
+        ctx_ = ctx;
+        num_items_ = n;
+        next_item_.store(0, std::memory_order_relaxed);
+        num_active_ = workers_.size();
+        ++generation_;
+    }
+    work_cv_.notify_all();
+
+    // Calling thread takes part in the loop
+    RunItems();
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this]() { return num_active_ == 0; });
+}
+
+void ThreadPool::RunItems() noexcept {
+    for (std::size_t i = next_item_.fetch_add(1); i < num_items_; i = next_item_.fetch_add(1)) {
+        invoke_(ctx_, i);
+    }
+}
+
+void ThreadPool::WorkerLoop() noexcept {
+    std::size_t seen_generation = 0;
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_cv_.wait(lock, [&]() { return stop_ || generation_ != seen_generation; });
+        if (stop_) {
+            return;
+        }
+        seen_generation = generation_;
+        lock.unlock();
+        RunItems();
+        lock.lock();
+        if (--num_active_ == 0) {
+            done_cv_.notify_one();
+        }
+    }
+}
+
+}    // namespace craftworld
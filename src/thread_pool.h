@@ -0,0 +1,74 @@
+#ifndef CRAFTWORLD_THREAD_POOL_H_
+#define CRAFTWORLD_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace craftworld {
+
+/**
+ * Fixed size pool of worker threads for data parallel loops.
+ * Work is handed out as indices, so running a loop performs no allocations.
+ */
+class ThreadPool {
+public:
+    /**
+     * @param num_threads Number of threads running each loop, including the calling thread
+     */
+    explicit ThreadPool(std::size_t num_threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool(ThreadPool &&) = delete;
+    auto operator=(const ThreadPool &) -> ThreadPool & = delete;
+    auto operator=(ThreadPool &&) -> ThreadPool & = delete;
+
+    /**
+     * Get the number of threads running each loop, including the calling thread.
+     * @return number of threads
+     */
+    [[nodiscard]] auto num_threads() const noexcept -> std::size_t;
+
+    /**
+     * Call func(i) for every i in [0, n) across the pool, and block until all calls have finished.
+     * @note func must not throw, and loops from multiple threads are run one after another
+     * @param n Number of indices
+     * @param func Callable taking the index
+     */
+    template <typename F>
+    void parallel_for(std::size_t n, F &&func) {
+        using FuncType = std::remove_reference_t<F>;
+        Run(
+            n, [](void *ctx, std::size_t i) { (*static_cast<FuncType *>(ctx))(i); },
+            const_cast<void *>(static_cast<const void *>(&func)));    // NOLINT(cppcoreguidelines-pro-type-const-cast)
+    }
+
+private:
+    using InvokeFn = void (*)(void *, std::size_t);
+
+    void Run(std::size_t n, InvokeFn invoke, void *ctx);
+    void RunItems() noexcept;
+    void WorkerLoop() noexcept;
+
+    std::vector<std::thread> workers_;
+    std::mutex run_mutex_;    // Serializes loops
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::size_t generation_ = 0;    // Incremented for each loop handed to the workers
+    std::size_t num_active_ = 0;    // Workers yet to finish the current loop
+    bool stop_ = false;
+    InvokeFn invoke_ = nullptr;
+    void *ctx_ = nullptr;
+    std::size_t num_items_ = 0;
+    std::atomic<std::size_t> next_item_{0};
+};
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_THREAD_POOL_H_
@@ -0,0 +1,326 @@
+#include "trajectory_log.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include "compression.h"
+#include "level_registry.h"
+
+namespace craftworld {
+
+namespace {
+// First byte of every record
+enum class RecordTag : uint8_t {
+    kLevel = 0,      // Level id, workshop swap flag and board string
+    kEpisode = 1,    // Varint payload size, then level id, varint number of steps and the steps
+};
+
+struct LogHeader {
+    uint32_t magic = kTrajectoryLogMagic;
+    uint32_t version = kTrajectoryLogVersion;
+};
+
+static_assert(std::has_unique_object_representations_v<LogHeader>);
+
+// Each step is the action, the lower 32 bits of the state hash and the varint reward signal
+constexpr std::size_t kHashBytes = 4;
+
+void put_u64(uint64_t value, std::vector<uint8_t> &out) {
+    for (std::size_t i = 0; i < sizeof(value); ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));    // NOLINT(*-magic-numbers)
+    }
+}
+
+auto get_bytes(const uint8_t *&data, const uint8_t *end, std::size_t size) -> const uint8_t * {
+    if (static_cast<std::size_t>(end - data) < size) {
+        throw std::invalid_argument("Trajectory log record is truncated.");
+    }
+    const uint8_t *bytes = data;
+    data += size;
+    return bytes;
+}
+
+auto get_u64(const uint8_t *&data, const uint8_t *end) -> uint64_t {
+    const uint8_t *bytes = get_bytes(data, end, sizeof(uint64_t));
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < sizeof(value); ++i) {
+        value |= static_cast<uint64_t>(bytes[i]) << (8 * i);    // NOLINT(*-magic-numbers)
+    }
+    return value;
+}
+
+auto truncate_hash(uint64_t hash) noexcept -> uint32_t {
+    return static_cast<uint32_t>(hash);
+}
+
+struct Step {
+    Action action;
+    uint32_t hash;
+    uint64_t reward_signal;
+};
+
+auto get_step(const uint8_t *&data, const uint8_t *end) -> Step {
+    Step step{};
+    const auto action = static_cast<Action>(*get_bytes(data, end, 1));
+    if (!CraftWorldGameState::is_valid_action(action)) {
+        throw std::invalid_argument("Invalid action in trajectory log.");
+    }
+    step.action = action;
+    const uint8_t *hash = get_bytes(data, end, kHashBytes);
+    for (std::size_t i = 0; i < kHashBytes; ++i) {
+        step.hash |= static_cast<uint32_t>(hash[i]) << (8 * i);    // NOLINT(*-magic-numbers)
+    }
+    step.reward_signal = get_varint(data, end);
+    return step;
+}
+}    // namespace
+
+TrajectoryLogWriter::TrajectoryLogWriter(std::string path) : path_(std::move(path)) {
+    // Append to an existing log after checking its header
+    bool is_new = true;
+    {
+        std::ifstream in(path_, std::ios::binary);
+        LogHeader header;
+        if (in && in.read(reinterpret_cast<char *>(&header), sizeof(header))) {    // NOLINT(*-reinterpret-cast)
+            if (header.magic != kTrajectoryLogMagic || header.version != kTrajectoryLogVersion) {
+                throw std::runtime_error(path_ + " is not a trajectory log.");
+            }
+            is_new = false;
+        } else if (in && in.gcount() > 0) {
+            throw std::runtime_error(path_ + " is not a trajectory log.");
+        }
+    }
+    out_.open(path_, std::ios::binary | (is_new ? std::ios::trunc : std::ios::app));
+    if (!out_) {
+        throw std::runtime_error("Unable to open " + path_ + " for writing.");
+    }
+    if (is_new) {
+        const LogHeader header;
+        out_.write(reinterpret_cast<const char *>(&header), sizeof(header));    // NOLINT(*-reinterpret-cast)
+        if (!out_) {
+            throw std::runtime_error("Unable to write trajectory log to " + path_ + ".");
+        }
+    }
+}
+
+TrajectoryLogWriter::~TrajectoryLogWriter() {
+    if (out_.is_open()) {
+        try {
+            close();
+        } catch (...) {    // NOLINT(bugprone-empty-catch)
+            // Destructor must not throw, call close() to observe write errors
+        }
+    }
+}
+
+void TrajectoryLogWriter::begin_episode(const CraftWorldGameState &state) {
+    // Replay starts from the cached starting board, so episodes must start there too
+    if (state != CraftWorldGameState(state.shared_state())) {
+        throw std::invalid_argument("Episodes must start from the starting state of their level.");
+    }
+    level_ = state.shared_state();
+    steps_.clear();
+    num_steps_ = 0;
+}
+
+void TrajectoryLogWriter::add_step(Action action, const CraftWorldGameState &state) {
+    if (!level_) {
+        throw std::invalid_argument("No episode was started with begin_episode().");
+    }
+    steps_.push_back(static_cast<uint8_t>(action));
+    const uint32_t hash = truncate_hash(state.get_hash());
+    for (std::size_t i = 0; i < kHashBytes; ++i) {
+        steps_.push_back(static_cast<uint8_t>(hash >> (8 * i)));    // NOLINT(*-magic-numbers)
+    }
+    put_varint(state.get_reward_signal(), steps_);
+    ++num_steps_;
+}
+
+void TrajectoryLogWriter::end_episode() {
+    if (!level_) {
+        throw std::invalid_argument("No episode was started with begin_episode().");
+    }
+    record_.clear();
+    const bool new_level = written_levels_.count(level_->level_id) == 0;
+    if (new_level) {
+        record_.push_back(static_cast<uint8_t>(RecordTag::kLevel));
+        put_u64(level_->level_id, record_);
+        record_.push_back(static_cast<uint8_t>(level_->workshop_swap));
+        put_varint(level_->game_board_str.size(), record_);
+        record_.insert(record_.end(), level_->game_board_str.begin(), level_->game_board_str.end());
+    }
+    std::vector<uint8_t> payload_header;
+    put_u64(level_->level_id, payload_header);
+    put_varint(num_steps_, payload_header);
+    record_.push_back(static_cast<uint8_t>(RecordTag::kEpisode));
+    put_varint(payload_header.size() + steps_.size(), record_);
+    record_.insert(record_.end(), payload_header.begin(), payload_header.end());
+    record_.insert(record_.end(), steps_.begin(), steps_.end());
+
+    // Whole episode is written at once
+    out_.write(reinterpret_cast<const char *>(record_.data()),    // NOLINT(*-reinterpret-cast)
+               static_cast<std::streamsize>(record_.size()));
+    if (!out_) {
+        throw std::runtime_error("Unable to write trajectory log to " + path_ + ".");
+    }
+    if (new_level) {
+        written_levels_.insert(level_->level_id);
+    }
+    level_.reset();
+    ++num_episodes_;
+}
+
+void TrajectoryLogWriter::close() {
+    if (!out_.is_open()) {
+        return;
+    }
+    out_.close();
+    if (!out_) {
+        throw std::runtime_error("Unable to write trajectory log to " + path_ + ".");
+    }
+}
+
+auto TrajectoryLogWriter::size() const noexcept -> std::size_t {
+    return num_episodes_;
+}
+
+// ---------------------------------------------------------------------------
+
+TrajectoryReplayer::TrajectoryReplayer(const std::string &path) : file_(path) {
+    LogHeader header;
+    if (file_.size() < sizeof(header)) {
+        throw std::runtime_error(path + " is not a trajectory log.");
+    }
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if (header.magic != kTrajectoryLogMagic) {
+        throw std::runtime_error(path + " is not a trajectory log.");
+    }
+    if (header.version != kTrajectoryLogVersion) {
+        throw std::runtime_error(path + " has an unsupported trajectory log version.");
+    }
+
+    // Index the episodes, only their headers are read
+    std::unordered_map<uint64_t, std::shared_ptr<const SharedStateInfo>> levels;
+    const uint8_t *pos = file_.data() + sizeof(header);
+    const uint8_t *end = file_.data() + file_.size();
+    try {
+        while (pos != end) {
+            const auto tag = static_cast<RecordTag>(*get_bytes(pos, end, 1));
+            if (tag == RecordTag::kLevel) {
+                const uint64_t level_id = get_u64(pos, end);
+                const bool workshop_swap = *get_bytes(pos, end, 1) != 0;
+                const auto length = static_cast<std::size_t>(get_varint(pos, end));
+                const auto *board = reinterpret_cast<const char *>(get_bytes(pos, end, length));    // NOLINT
+                auto level = LevelRegistry::instance().add(std::string(board, length), workshop_swap);
+                if (level->level_id != level_id) {
+                    throw std::invalid_argument("Level id does not match its board.");
+                }
+                levels[level_id] = std::move(level);
+            } else if (tag == RecordTag::kEpisode) {
+                const auto size = static_cast<std::size_t>(get_varint(pos, end));
+                Episode episode;
+                const uint8_t *payload = get_bytes(pos, end, size);
+                episode.end = payload + size;
+                const auto it = levels.find(get_u64(payload, episode.end));
+                if (it == levels.end()) {
+                    throw std::invalid_argument("Episode of an undefined level.");
+                }
+                episode.level = it->second;
+                episode.num_steps = static_cast<std::size_t>(get_varint(payload, episode.end));
+                episode.steps = payload;
+                episodes_.push_back(std::move(episode));
+            } else {
+                throw std::invalid_argument("Unknown record type.");
+            }
+        }
+    } catch (const std::logic_error &e) {
+        // std::invalid_argument or std::out_of_range, i.e. from parsing a board string
+        throw std::runtime_error(path + " is a corrupt trajectory log: " + e.what());
+    }
+}
+
+auto TrajectoryReplayer::num_steps(std::size_t index) const -> std::size_t {
+    return episodes_.at(index).num_steps;
+}
+
+auto TrajectoryReplayer::level(std::size_t index) const -> const std::shared_ptr<const SharedStateInfo> & {
+    return episodes_.at(index).level;
+}
+
+auto TrajectoryReplayer::trajectory(std::size_t index) const -> Trajectory {
+    const Episode &episode = episodes_.at(index);
+    Trajectory trajectory;
+    trajectory.level_id = episode.level->level_id;
+    trajectory.actions.reserve(episode.num_steps);
+    trajectory.hashes.reserve(episode.num_steps);
+    trajectory.reward_signals.reserve(episode.num_steps);
+    const uint8_t *pos = episode.steps;
+    try {
+        for (std::size_t i = 0; i < episode.num_steps; ++i) {
+            const Step step = get_step(pos, episode.end);
+            trajectory.actions.push_back(step.action);
+            trajectory.hashes.push_back(step.hash);
+            trajectory.reward_signals.push_back(step.reward_signal);
+        }
+    } catch (const std::logic_error &e) {
+        throw std::runtime_error(std::string("Corrupt trajectory log episode: ") + e.what());
+    }
+    return trajectory;
+}
+
+auto TrajectoryReplayer::Replay(const Episode &episode, std::size_t num_steps, CraftWorldGameState &state) const
+    -> bool {
+    const uint8_t *pos = episode.steps;
+    for (std::size_t i = 0; i < num_steps; ++i) {
+        const Step step = get_step(pos, episode.end);
+        state.apply_action(step.action);
+        if (truncate_hash(state.get_hash()) != step.hash || state.get_reward_signal() != step.reward_signal) {
+            return false;
+        }
+    }
+    return true;
+}
+
+auto TrajectoryReplayer::state(std::size_t index, std::size_t step) const -> CraftWorldGameState {
+    const Episode &episode = episodes_.at(index);
+    if (step > episode.num_steps) {
+        throw std::out_of_range("Step is past the end of the episode.");
+    }
+    CraftWorldGameState state(episode.level);
+    bool matches = false;
+    try {
+        matches = Replay(episode, step, state);
+    } catch (const std::logic_error &e) {
+        throw std::runtime_error(std::string("Corrupt trajectory log episode: ") + e.what());
+    }
+    if (!matches) {
+        throw std::runtime_error("Replay does not match the recorded episode.");
+    }
+    return state;
+}
+
+auto TrajectoryReplayer::verify(std::size_t index) const noexcept -> bool {
+    try {
+        const Episode &episode = episodes_.at(index);
+        CraftWorldGameState state(episode.level);
+        return Replay(episode, episode.num_steps, state);
+    } catch (...) {
+        return false;
+    }
+}
+
+auto TrajectoryReplayer::verify(ThreadPool &pool) const -> std::vector<std::size_t> {
+    std::vector<uint8_t> matches(episodes_.size());
+    pool.parallel_for(episodes_.size(), [&](std::size_t i) { matches[i] = static_cast<uint8_t>(verify(i)); });
+    std::vector<std::size_t> mismatches;
+    for (std::size_t i = 0; i < matches.size(); ++i) {
+        if (matches[i] == 0) {
+            mismatches.push_back(i);
+        }
+    }
+    return mismatches;
+}
+
+}    // namespace craftworld
@@ -0,0 +1,184 @@
+#ifndef CRAFTWORLD_TRAJECTORY_LOG_H_
+#define CRAFTWORLD_TRAJECTORY_LOG_H_
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "craftworld_base.h"
+#include "definitions.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+namespace craftworld {
+
+// Magic number at the start of every trajectory log ("CWTL" in little-endian byte order)
+constexpr uint32_t kTrajectoryLogMagic = 0x4C545743;
+constexpr uint32_t kTrajectoryLogVersion = 1;
+
+// One recorded episode, the step vectors all have the same length
+struct Trajectory {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint64_t level_id = 0;
+    std::vector<Action> actions;             // Action applied at each step
+    std::vector<uint32_t> hashes;            // Lower 32 bits of the state hash after each step
+    std::vector<uint64_t> reward_signals;    // Reward signal after each step
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+/**
+ * Append-only writer of a trajectory log.
+ * Episodes are stored as their level id and the action, truncated state hash and reward signal of each step, which
+ * is about 6 bytes per step. The definition of each level is stored once per writer, so a log can be replayed in a
+ * process which has not loaded the levels. An episode is only written by end_episode(), so an interrupted episode
+ * never leaves a partial record.
+ */
+class TrajectoryLogWriter {
+public:
+    /**
+     * @param path Log file to write, episodes are appended if the file is an existing log
+     * @throw std::runtime_error if the file cannot be opened or is not a trajectory log
+     */
+    explicit TrajectoryLogWriter(std::string path);
+    ~TrajectoryLogWriter();
+
+    TrajectoryLogWriter(const TrajectoryLogWriter &) = delete;
+    TrajectoryLogWriter(TrajectoryLogWriter &&) = delete;
+    auto operator=(const TrajectoryLogWriter &) -> TrajectoryLogWriter & = delete;
+    auto operator=(TrajectoryLogWriter &&) -> TrajectoryLogWriter & = delete;
+
+    /**
+     * Start recording an episode, discarding any episode which was not ended.
+     * @param state Starting state of the episode, as given by reset()
+     * @throw std::invalid_argument if the state is not the starting state of its level
+     */
+    void begin_episode(const CraftWorldGameState &state);
+
+    /**
+     * Record a step of the current episode.
+     * @param action Action which was applied
+     * @param state State after applying the action
+     * @throw std::invalid_argument if no episode was started
+     */
+    void add_step(Action action, const CraftWorldGameState &state);
+
+    /**
+     * Append the current episode to the log.
+     * @throw std::invalid_argument if no episode was started
+     * @throw std::runtime_error if writing fails
+     */
+    void end_episode();
+
+    /**
+     * Flush and close the file. Further calls to end_episode() are invalid.
+     * @throw std::runtime_error if writing fails
+     */
+    void close();
+
+    /**
+     * Get the number of episodes written by this writer.
+     * @return number of episodes
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+private:
+    std::string path_;
+    std::ofstream out_;
+    std::unordered_set<uint64_t> written_levels_;     // Levels already defined in the log by this writer
+    std::shared_ptr<const SharedStateInfo> level_;    // Level of the current episode, nullptr if none
+    std::vector<uint8_t> steps_;                      // Encoded steps of the current episode
+    std::size_t num_steps_ = 0;
+    std::vector<uint8_t> record_;    // Reusable buffer for the records of an episode
+    std::size_t num_episodes_ = 0;
+};
+
+/**
+ * Memory mapped, read-only trajectory log written by TrajectoryLogWriter.
+ * Episodes are replayed from the cached starting board of their level, checking the recorded hash and reward signal
+ * of every step. Levels defined in the log are added to the global LevelRegistry.
+ * All methods are const, so one replayer can be used from multiple threads.
+ */
+class TrajectoryReplayer {
+public:
+    /**
+     * @param path Log file to open
+     * @throw std::runtime_error if the file cannot be opened or is not a valid trajectory log
+     */
+    explicit TrajectoryReplayer(const std::string &path);
+
+    /**
+     * Get the number of episodes in the log.
+     * @return number of episodes
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+        return episodes_.size();
+    }
+
+    /**
+     * Get the number of steps of an episode.
+     * @param index Episode index, less than size()
+     * @return number of steps
+     */
+    [[nodiscard]] auto num_steps(std::size_t index) const -> std::size_t;
+
+    /**
+     * Get the level of an episode.
+     * @param index Episode index, less than size()
+     * @return shared level information
+     */
+    [[nodiscard]] auto level(std::size_t index) const -> const std::shared_ptr<const SharedStateInfo> &;
+
+    /**
+     * Decode the recorded steps of an episode.
+     * @param index Episode index
+     * @return recorded episode
+     * @throw std::out_of_range if index is not less than size()
+     * @throw std::runtime_error if the episode record is corrupt
+     */
+    [[nodiscard]] auto trajectory(std::size_t index) const -> Trajectory;
+
+    /**
+     * Reconstruct the state of an episode after the given number of steps by replaying its actions.
+     * @param index Episode index
+     * @param step Number of steps to replay, 0 gives the starting state
+     * @return state after the given step
+     * @throw std::out_of_range if index is not less than size(), or step is larger than num_steps(index)
+     * @throw std::runtime_error if the replay does not match the recorded hashes, or the episode record is corrupt
+     */
+    [[nodiscard]] auto state(std::size_t index, std::size_t step) const -> CraftWorldGameState;
+
+    /**
+     * Replay a whole episode and check it matches its record.
+     * @param index Episode index, less than size()
+     * @return true if every step matches the recorded hash and reward signal
+     */
+    [[nodiscard]] auto verify(std::size_t index) const noexcept -> bool;
+
+    /**
+     * Replay and check all episodes in parallel.
+     * @param pool Threads to replay the episodes on
+     * @return indices of the episodes which do not match their record, in increasing order
+     */
+    [[nodiscard]] auto verify(ThreadPool &pool) const -> std::vector<std::size_t>;
+
+private:
+    struct Episode {
+        std::shared_ptr<const SharedStateInfo> level;
+        const uint8_t *steps = nullptr;    // Encoded steps in the mapped file
+        const uint8_t *end = nullptr;      // End of the episode record
+        std::size_t num_steps = 0;
+    };
+
+    // Replay num_steps steps of the episode, checking each one, and return false on the first mismatch
+    auto Replay(const Episode &episode, std::size_t num_steps, CraftWorldGameState &state) const -> bool;
+
+    MappedFile file_;
+    std::vector<Episode> episodes_;
+};
+
+}    // namespace craftworld
+
+#endif    // CRAFTWORLD_TRAJECTORY_LOG_H_
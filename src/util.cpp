@@ -1,29 +1,69 @@
+#include <algorithm>
 #include <cassert>
-#include <sstream>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
 #include <string>
-#include <vector>
+#include <string_view>
 
 #include "definitions.h"
+#include "util.h"
 
 namespace craftworld::util {
 
+namespace {
+// Parse the integer at the start of the token like std::stoi: leading whitespace and a '+' sign are skipped, and
+// anything after the number is ignored
+auto parse_int(std::string_view token) -> int {
+    const char *first = token.data();
+    const char *last = first + token.size();
+    if (first != last && (*first < '0' || *first > '9')) {
+        while (first != last && std::isspace(static_cast<unsigned char>(*first)) != 0) {
+            ++first;
+        }
+        if (first != last && *first == '+' && std::next(first) != last && *std::next(first) != '-') {
+            ++first;
+        }
+    }
+    int value = 0;
+    const auto [ptr, ec] = std::from_chars(first, last, value);
+    if (ec == std::errc::invalid_argument) {
+        throw std::invalid_argument(std::string("Board string value is not a number: ") + std::string(token));
+    }
+    if (ec == std::errc::result_out_of_range) {
+        throw std::out_of_range(std::string("Board string value is out of range: ") + std::string(token));
+    }
+    return value;
+}
+}    // namespace
+
 auto parse_board_str(const std::string &board_str) -> Board {
-    std::stringstream board_ss(board_str);
-    std::string segment;
-    std::vector<std::string> seglist;
-    // string split on |
-    while (std::getline(board_ss, segment, '|')) {
-        seglist.push_back(segment);
-    }
-    if (seglist.size() < 4) {
+    const char *pos = board_str.data();
+    const char *end = pos + board_str.size();
+    // A trailing separator does not start another value
+    if (pos != end && *std::prev(end) == '|') {
+        --end;
+    }
+    const auto num_values = pos == end ? 0 : static_cast<std::size_t>(std::count(pos, end, '|')) + 1;
+    if (num_values < 4) {
         throw std::invalid_argument("Board string should have at minimum 4 values separated by '|'.");
     }
 
+    // Values are read in a single pass, without splitting the string
+    const auto next_token = [&]() -> std::string_view {
+        const char *separator = std::find(pos, end, '|');
+        const std::string_view token(pos, static_cast<std::size_t>(separator - pos));
+        pos = separator == end ? end : std::next(separator);
+        return token;
+    };
+
     // Get general info
-    const auto rows = static_cast<std::size_t>(std::stoi(seglist[0]));
-    const auto cols = static_cast<std::size_t>(std::stoi(seglist[1]));
-    const auto goal = static_cast<std::size_t>(std::stoi(seglist[2]));
-    if (seglist.size() != static_cast<std::size_t>(rows * cols) + 3) {
+    const auto rows = static_cast<std::size_t>(parse_int(next_token()));
+    const auto cols = static_cast<std::size_t>(parse_int(next_token()));
+    const auto goal = static_cast<std::size_t>(parse_int(next_token()));
+    if (num_values != static_cast<std::size_t>(rows * cols) + 3) {
         throw std::invalid_argument("Supplied rows/cols does not match input board length.");
     }
     if (goal < kPrimitiveStart || goal >= (kNumPrimitive + kNumRecipeTypes + kPrimitiveStart)) {
@@ -33,20 +73,44 @@ auto parse_board_str(const std::string &board_str) -> Board {
     Board board(rows, cols, static_cast<Element>(goal));
 
     // Parse grid
-    for (std::size_t i = 3; i < seglist.size(); ++i) {
-        const int el_idx = std::stoi(seglist[i]);
-        if (el_idx < 0 || el_idx > kNumElements) {
-            throw std::invalid_argument(std::string("Unknown element type: ") + seglist[i]);
+    for (std::size_t i = 0; i < rows * cols; ++i) {
+        const std::string_view token = next_token();
+        const int el_idx = parse_int(token);
+        if (el_idx < 0 || el_idx >= kNumElements) {
+            throw std::invalid_argument(std::string("Unknown element type: ") + std::string(token));
         }
 
         if (static_cast<Element>(el_idx) == Element::kAgent) {
-            board.agent_idx = static_cast<std::size_t>(i) - 3;
+            board.agent_idx = i;
         }
 
-        board.item(i - 3) = static_cast<Element>(el_idx);
+        board.item(i) = static_cast<Element>(el_idx);
     }
 
     return board;
 }
 
+auto to_board_str(const Board &board) -> std::string {
+    std::string out = std::to_string(board.rows) + "|" + std::to_string(board.cols) + "|" +
+                      std::to_string(static_cast<int>(board.goal));
+    out.reserve(out.size() + (3 * board.grid.size()));
+    for (const Element el : board.grid) {
+        const auto value = static_cast<int>(el);
+        out.push_back('|');
+        out.push_back(static_cast<char>('0' + (value / 10)));    // NOLINT(*-magic-numbers)
+        out.push_back(static_cast<char>('0' + (value % 10)));    // NOLINT(*-magic-numbers)
+    }
+    return out;
+}
+
+auto level_id(const std::string &board_str, bool workshop_swap) noexcept -> uint64_t {
+    constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+    constexpr uint64_t kFnvPrime = 1099511628211ULL;
+    uint64_t hash = kFnvOffsetBasis;
+    for (const char c : board_str) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * kFnvPrime;
+    }
+    return (hash ^ static_cast<uint64_t>(workshop_swap)) * kFnvPrime;
+}
+
 }    // namespace craftworld::util
@@ -1,6 +1,7 @@
 #ifndef CRAFTWORLD_UTIL_H_
 #define CRAFTWORLD_UTIL_H_
 
+#include <cstdint>
 #include <string>
 
 #include "definitions.h"
@@ -9,6 +10,21 @@ namespace craftworld::util {
 
 auto parse_board_str(const std::string &board_str) -> Board;
 
+/**
+ * Get the board string of a board, formatted as scripts/generate_levelset.py writes it (cells as 2 digits).
+ * @param board Board to format
+ * @return board string, which parse_board_str() parses back into the same board
+ */
+auto to_board_str(const Board &board) -> std::string;
+
+/**
+ * Get the id of a level, which is the 64 bit FNV-1a hash of the board string and workshop swap flag.
+ * @param board_str Board string of the level
+ * @param workshop_swap Whether the workshops are swapped
+ * @return level id
+ */
+auto level_id(const std::string &board_str, bool workshop_swap) noexcept -> uint64_t;
+
 }    // namespace craftworld::util
 
 #endif    // CRAFTWORLD_UTIL_H_
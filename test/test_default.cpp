@@ -1,6 +1,7 @@
 #include <craftworld/craftworld.h>
 
 #include <iostream>
+#include <sstream>
 
 using namespace craftworld;
 
@@ -11,6 +12,19 @@ void test_default() {
     std::cout << state.is_solution() << std::endl;
 }
 
+void test_to_string() {
+    CraftWorldGameState state(kDefaultGameParams);
+    state.add_to_inventory(Element::kWood, 12);
+    std::ostringstream ss;
+    ss << state;
+    std::string text;
+    state.to_string_into(text);
+    if (text != ss.str()) {
+        std::cout << "to_string error." << std::endl;
+    }
+}
+
 int main() {
     test_default();
+    test_to_string();
 }
@@ -0,0 +1,70 @@
+#include <craftworld/craftworld.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+using namespace craftworld;
+
+namespace {
+int num_errors = 0;
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << msg << " error." << std::endl;
+        ++num_errors;
+    }
+}
+}    // namespace
+
+void test_generate_level() {
+    LevelGeneratorConfig config;
+    config.map_size = 14;
+    config.num_grass = 2;
+    check(generate_level(config, 7) == generate_level(config, 7), "deterministic level");
+    check(generate_level(config, 7) != generate_level(config, 8), "level seed");
+
+    ThreadPool pool(2);
+    const auto levels = generate_levels(config, 0, 200, pool);
+    check(levels[7] == generate_level(config, 7), "parallel level");
+    bool valid = true;
+    for (const auto &level : levels) {
+        const Board board = SharedStateInfo(level, false).initial_board;
+        valid &= level.size() == 8 + (3 * 14 * 14) && level.rfind("14|14|", 0) == 0;
+        const auto count = [&](Element el) { return std::count(board.grid.begin(), board.grid.end(), el); };
+        valid &= count(Element::kAgent) == 1 && count(Element::kWorkshop1) == 1 && count(Element::kFurnace) == 1;
+        valid &= count(Element::kGrass) == 2 && count(Element::kCopper) == 1 && count(Element::kTin) == 1;
+        // Gem ring levels put the gem in a stone cave
+        if (board.goal == Element::kGemRing) {
+            const auto gem = static_cast<std::size_t>(
+                std::find(board.grid.begin(), board.grid.end(), Element::kGem) - board.grid.begin());
+            valid &= count(Element::kStone) == 4 && board.item(gem - 1) == Element::kStone &&
+                     board.item(gem + board.cols) == Element::kStone;
+        }
+        // Agent is never next to another element
+        const std::size_t row = board.agent_idx / board.cols;
+        const std::size_t col = board.agent_idx % board.cols;
+        for (std::size_t r = std::max<std::size_t>(row, 1) - 1; r <= std::min(row + 1, board.rows - 1); ++r) {
+            for (std::size_t c = std::max<std::size_t>(col, 1) - 1; c <= std::min(col + 1, board.cols - 1); ++c) {
+                valid &= (r * board.cols) + c == board.agent_idx || board.item((r * board.cols) + c) == Element::kEmpty;
+            }
+        }
+    }
+    check(valid, "level placement");
+
+    config.recipe_probs = kRecipeProbsTest;
+    check(SharedStateInfo(generate_level(config, 0), false).initial_board.goal == Element::kGemRing,
+          "recipe probabilities");
+
+    config.map_size = 4;
+    try {
+        (void)generate_level(config, 0);
+        check(false, "map too small");
+    } catch (const std::invalid_argument &) {
+    }
+}
+
+int main() {
+    test_generate_level();
+    return num_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#include <craftworld/craftworld.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <string>
+
+using namespace craftworld;
+
+namespace {
+int num_errors = 0;
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << msg << " error." << std::endl;
+        ++num_errors;
+    }
+}
+}    // namespace
+
+void test_level_stream() {
+    LevelGeneratorConfig config;
+    config.map_size = 12;
+
+    // A single generator produces the levels in seed order
+    {
+        LevelStream stream(config, 100, 4, 1);
+        check(stream.capacity() == 4, "stream capacity");
+        bool in_order = true;
+        for (uint64_t i = 0; i < 50; ++i) {
+            in_order &= stream.pop()->game_board_str == generate_level(config, 100 + i);
+        }
+        check(in_order, "stream order");
+        check(stream.num_generated() >= 50, "stream count");
+        check(LevelRegistry::instance().find(stream.pop()->level_id) == nullptr, "stream not registered");
+    }
+
+    // Multiple generators never repeat a seed
+    {
+        LevelStream stream(config, 0, 8, 3);
+        std::set<std::string> levels;
+        for (int i = 0; i < 200; ++i) {
+            auto level = stream.try_pop();
+            levels.insert(level ? level->game_board_str : stream.make_state().shared_state()->game_board_str);
+        }
+        check(levels.size() == 200, "stream unique levels");
+    }
+
+    // Seeds of a crowded map which cannot place every element are skipped
+    {
+        config.map_size = 8;
+        LevelStream stream(config, 0, 8, 2);
+        for (int i = 0; i < 200; ++i) {
+            (void)stream.pop();
+        }
+        check(stream.num_skipped() > 0, "stream skipped seeds");
+    }
+
+    config.map_size = 4;
+    try {
+        LevelStream stream(config, 0);
+        check(false, "stream invalid config");
+    } catch (const std::invalid_argument &) {
+    }
+}
+
+int main() {
+    test_level_stream();
+    return num_errors == 0 ? 0 : 1;
+}
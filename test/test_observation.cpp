@@ -0,0 +1,148 @@
+#include <craftworld/craftworld.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+using namespace craftworld;
+
+namespace {
+int num_errors = 0;
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << msg << " error." << std::endl;
+        ++num_errors;
+    }
+}
+
+// Check that HWC observation is the transpose of the CHW observation
+void check_transpose(const std::vector<float> &chw, const std::vector<float> &hwc, const std::array<int, 3> &shape,
+                     const std::string &msg) {
+    const auto channels = static_cast<std::size_t>(shape[0]);
+    const auto cells = static_cast<std::size_t>(shape[1] * shape[2]);
+    bool is_same = chw.size() == hwc.size() && chw.size() == channels * cells;
+    for (std::size_t c = 0; is_same && c < channels; ++c) {
+        for (std::size_t i = 0; i < cells; ++i) {
+            is_same &= chw[c * cells + i] == hwc[i * channels + c];
+        }
+    }
+    check(is_same, msg);
+}
+}    // namespace
+
+void test_layout() {
+    CraftWorldGameState state(kDefaultGameParams);
+    state.add_to_inventory(Element::kWood, 2);
+    state.add_to_inventory(Element::kIron, 1);
+    state.apply_action(Action::kDown);
+
+    const auto shape = state.observation_shape();
+    const auto shape_hwc = state.observation_shape(ObservationLayout::kHWC);
+    check(shape[0] == shape_hwc[2] && shape[1] == shape_hwc[0] && shape[2] == shape_hwc[1], "observation shape");
+
+    check_transpose(state.get_observation(), state.get_observation(ObservationLayout::kHWC), shape, "observation");
+    check_transpose(state.get_binary_observation(), state.get_binary_observation(ObservationLayout::kHWC),
+                    state.observation_shape_binary(), "binary observation");
+    check_transpose(state.get_observation_environment(),
+                    state.get_observation_environment(ObservationLayout::kHWC), state.observation_shape_environment(),
+                    "environment observation");
+
+    std::vector<float> obs;
+    state.get_observation(obs, ObservationLayout::kHWC);
+    check(obs == state.get_observation(ObservationLayout::kHWC), "observation reuse");
+}
+
+void test_frame_stack() {
+    CraftWorldGameState state(kDefaultGameParams);
+    FrameStack stack(3, ObservationType::kFull, ObservationLayout::kHWC);
+    try {
+        stack.push(state);
+        check(false, "frame stack push before reset");
+    } catch (const std::logic_error &) {
+    }
+    stack.reset(state);
+
+    std::vector<std::vector<float>> history(3, state.get_observation(ObservationLayout::kHWC));
+    const std::vector<Action> actions{Action::kDown, Action::kRight, Action::kUse, Action::kLeft, Action::kDown};
+    for (const auto &action : actions) {
+        state.apply_action(action);
+        stack.push(state);
+        history.erase(history.begin());
+        history.push_back(state.get_observation(ObservationLayout::kHWC));
+
+        std::vector<float> expected;
+        for (const auto &obs : history) {
+            expected.insert(expected.end(), obs.begin(), obs.end());
+        }
+        check(stack.to_vector() == expected, "frame stack");
+        check(std::equal(history.back().begin(), history.back().end(), stack.frame(2)), "frame stack newest");
+    }
+    check(stack.shape()[0] == 3 && stack.shape()[3] == static_cast<int>(kNumChannels), "frame stack shape");
+
+    // States of a level with a different size do not fit the stack
+    LevelGeneratorConfig config;
+    config.map_size = 8;
+    const CraftWorldGameState small_state(std::make_shared<const SharedStateInfo>(generate_level(config, 0), false));
+    try {
+        stack.push(small_state);
+        check(false, "frame stack shape");
+    } catch (const std::invalid_argument &) {
+    }
+}
+
+void test_half_precision() {
+    CraftWorldGameState state(kDefaultGameParams);
+    state.add_to_inventory(Element::kStick, 3);
+    state.apply_action(Action::kRight);
+
+    const auto obs = state.get_observation(ObservationLayout::kHWC);
+    std::vector<Float16> obs_fp16(obs.size());
+    std::vector<BFloat16> obs_bf16(obs.size());
+    state.get_observation(obs_fp16.data(), ObservationLayout::kHWC);
+    state.get_observation(obs_bf16.data(), ObservationLayout::kHWC);
+    bool is_same = true;
+    for (std::size_t i = 0; i < obs.size(); ++i) {
+        is_same &= static_cast<float>(obs_fp16[i]) == obs[i] && static_cast<float>(obs_bf16[i]) == obs[i];
+    }
+    check(is_same, "half precision observation");
+
+    const auto obs_binary = state.get_binary_observation();
+    std::vector<BFloat16> obs_binary_bf16(obs_binary.size());
+    state.get_binary_observation(obs_binary_bf16.data());
+    is_same = true;
+    for (std::size_t i = 0; i < obs_binary.size(); ++i) {
+        is_same &= static_cast<float>(obs_binary_bf16[i]) == obs_binary[i];
+    }
+    check(is_same, "bfloat16 binary observation");
+
+    check(static_cast<float>(Float16(0.1F)) == 0.0999755859375F, "fp16 rounding");
+    check(static_cast<float>(Float16(1e-7F)) == 1.1920928955078125e-07F, "fp16 subnormal");
+    check(static_cast<float>(BFloat16(1.00390625F)) == 1.0F, "bf16 rounding");
+}
+
+void test_batch() {
+    std::vector<CraftWorldGameState> states(3, CraftWorldGameState(kDefaultGameParams));
+    states[1].apply_action(Action::kDown);
+    states[2].add_to_inventory(Element::kWood, 1);
+
+    const std::size_t obs_size = states[0].observation_size(ObservationType::kEnvironment);
+    std::vector<Float16> batch(states.size() * obs_size);
+    get_observation_batch(states, batch.data(), ObservationType::kEnvironment, ObservationLayout::kHWC);
+    bool is_same = true;
+    for (std::size_t b = 0; b < states.size(); ++b) {
+        const auto obs = states[b].get_observation_environment(ObservationLayout::kHWC);
+        for (std::size_t i = 0; i < obs_size; ++i) {
+            is_same &= static_cast<float>(batch[b * obs_size + i]) == obs[i];
+        }
+    }
+    check(is_same, "observation batch");
+}
+
+int main() {
+    test_layout();
+    test_frame_stack();
+    test_half_precision();
+    test_batch();
+    return num_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+#include <craftworld/craftworld.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace craftworld;
+
+namespace {
+int num_errors = 0;
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << msg << " error." << std::endl;
+        ++num_errors;
+    }
+}
+}    // namespace
+
+void test_incremental_render() {
+    CraftWorldGameState state(kDefaultGameParams);
+    Renderer renderer(state);
+    check(renderer.render() == state.to_image(), "initial render");
+
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<int> action_dist(0, kNumActions - 1);
+    bool is_same = true;
+    for (int step = 0; step < 500; ++step) {
+        state.apply_action(static_cast<Action>(action_dist(gen)));
+        if (step % 50 == 0) {
+            state.add_to_inventory(Element::kWood, 1);
+        }
+        is_same &= renderer.render() == state.to_image();
+    }
+    check(is_same, "incremental render");
+
+    state.reset();
+    check(renderer.render() == state.to_image(), "render after reset");
+    check(renderer.image_shape() == state.image_shape(), "render shape");
+}
+
+void test_tile_sizes() {
+    CraftWorldGameState state(kDefaultGameParams);
+    state.add_to_inventory(Element::kStick, 2);
+    for (const int tile_size : kSupportedTileSizes) {
+        const auto shape = state.image_shape(tile_size);
+        const auto img = state.to_image(tile_size);
+        check(img.size() == shape[0] * shape[1] * shape[2], "image shape");
+        check(shape[0] == (state.observation_shape()[1] + 4) * static_cast<std::size_t>(tile_size), "image height");
+
+        Renderer renderer(state, tile_size);
+        state.apply_action(Action::kDown);
+        check(renderer.render() == state.to_image(tile_size), "low resolution render");
+    }
+    check(state.to_image(SPRITE_WIDTH) == state.to_image(), "full resolution render");
+
+    bool has_thrown = false;
+    try {
+        const auto img = state.to_image(12);
+    } catch (const std::invalid_argument &) {
+        has_thrown = true;
+    }
+    check(has_thrown, "unsupported tile size");
+}
+
+void test_batch_render() {
+    std::vector<CraftWorldGameState> states(16, CraftWorldGameState(kDefaultGameParams));
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<int> action_dist(0, kNumActions - 1);
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        for (std::size_t step = 0; step < i * 5; ++step) {
+            states[i].apply_action(static_cast<Action>(action_dist(gen)));
+        }
+        states[i].add_to_inventory(Element::kPlank, i % 3);
+    }
+
+    BatchRenderer renderer(4, 16);
+    const std::size_t img_size = renderer.image_size(states[0]);
+    std::vector<uint8_t> batch(states.size() * img_size, 0xFF);
+    renderer.render(states, batch.data());
+    bool is_same = true;
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        const auto img = states[i].to_image(16);
+        is_same &= std::equal(img.begin(), img.end(), batch.begin() + static_cast<std::ptrdiff_t>(i * img_size));
+    }
+    check(is_same, "batch render");
+
+    // Rendering into a dirty buffer must overwrite every byte
+    std::vector<uint8_t> img(states[0].to_image().size(), 0xFF);
+    states[0].render_into(img.data());
+    check(img == states[0].to_image(), "render into");
+}
+
+void test_image_formats() {
+    CraftWorldGameState state(kDefaultGameParams);
+    state.add_to_inventory(Element::kGem, 1);
+    const auto rgb = state.to_image();
+    const auto indexed = state.to_image(SPRITE_WIDTH, ImageFormat::kPalette);
+    const auto gray = state.to_image(SPRITE_WIDTH, ImageFormat::kGrayscale);
+    const auto shape = state.image_shape(SPRITE_WIDTH, ImageFormat::kPalette);
+    check(shape[2] == 1 && indexed.size() * 3 == rgb.size() && gray.size() * 3 == rgb.size(), "image format shape");
+
+    const auto &palette = get_image_palette();
+    check(palette.size() == kPaletteSize * 3 && palette[0] == 0 && palette[1] == 0 && palette[2] == 0, "palette");
+    std::size_t abs_error = 0;
+    bool is_gray = true;
+    for (std::size_t i = 0; i < indexed.size(); ++i) {
+        for (std::size_t ch = 0; ch < 3; ++ch) {
+            abs_error += static_cast<std::size_t>(std::abs(palette[indexed[i] * 3 + ch] - rgb[i * 3 + ch]));
+        }
+        const int luma = (299 * rgb[i * 3] + 587 * rgb[i * 3 + 1] + 114 * rgb[i * 3 + 2] + 500) / 1000;
+        is_gray &= gray[i] == luma;
+    }
+    check(abs_error < rgb.size() * 2, "palette quantization");
+    check(is_gray, "grayscale");
+
+    Renderer renderer(state, 16, ImageFormat::kPalette);
+    state.apply_action(Action::kDown);
+    state.add_to_inventory(Element::kGem, 1);
+    check(renderer.render() == state.to_image(16, ImageFormat::kPalette), "palette render");
+}
+
+void test_recorder() {
+    CraftWorldGameState state(kDefaultGameParams);
+    const std::string path = "test_recorder.y4m";
+    {
+        EpisodeRecorder recorder(state, path, VideoFormat::kY4M, 8);
+        for (int step = 0; step < 5; ++step) {
+            recorder.record();
+            state.apply_action(Action::kDown);
+        }
+        check(recorder.num_frames() == 5, "recorder frame count");
+    }
+    const auto shape = state.image_shape(8);
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    const std::string header = "YUV4MPEG2 W" + std::to_string(shape[1]) + " H" + std::to_string(shape[0]) +
+                               " F10:1 Ip A1:1 C444\n";
+    const auto expected_size = header.size() + 5 * (6 + 3 * shape[0] * shape[1]);
+    check(static_cast<std::size_t>(in.tellg()) == expected_size, "recorder file size");
+    in.close();
+
+    // Resetting to a level of a different size cannot continue the stream
+    {
+        EpisodeRecorder recorder(state, path, VideoFormat::kY4M, 8);
+        recorder.record();
+        LevelGeneratorConfig config;
+        config.map_size = 8;
+        state = CraftWorldGameState(std::make_shared<const SharedStateInfo>(generate_level(config, 0), false));
+        try {
+            recorder.record();
+            check(false, "recorder frame size");
+        } catch (const std::runtime_error &) {
+        }
+    }
+    std::remove(path.c_str());
+}
+
+int main() {
+    test_incremental_render();
+    test_tile_sizes();
+    test_batch_render();
+    test_image_formats();
+    test_recorder();
+    return num_errors == 0 ? 0 : 1;
+}
@@ -1,7 +1,24 @@
 #include <craftworld/craftworld.h>
 
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
 using namespace craftworld;
 
+namespace {
+int num_errors = 0;
+
+void fail(const std::string &msg) {
+    std::cout << msg << " error." << std::endl;
+    ++num_errors;
+}
+}    // namespace
+
 void test_serialization() {
     const std::string board_str =
         "14|14|25|26|26|26|26|26|26|26|26|12|26|26|26|26|26|26|26|26|26|26|26|26|26|26|26|26|26|26|26|26|26|26|26|26|"
@@ -20,24 +37,484 @@ void test_serialization() {
 
     CraftWorldGameState state_copy(bytes);
 
+    // Deserialized states attach to the shared level information in the global registry
+    if (LevelRegistry::instance().find(state_copy.level_id()) == nullptr || state.level_id() != state_copy.level_id()) {
+        fail("serialization");
+    }
+
     state.apply_action(Action(2));
     state.apply_action(Action(2));
     state_copy.apply_action(Action(2));
     state_copy.apply_action(Action(2));
 
     if (state != state_copy) {
-        std::cout << "serialization error." << std::endl;
+        fail("serialization");
     }
     std::cout << state << std::endl;
     std::cout << state.get_hash() << std::endl;
 
     if (state.get_hash() != state_copy.get_hash()) {
-        std::cout << "serialization error." << std::endl;
+        fail("serialization");
     }
     std::cout << state_copy << std::endl;
     std::cout << state_copy.get_hash() << std::endl;
 }
 
+void test_serialize_into() {
+    CraftWorldGameState state(kDefaultGameParams);
+    state.apply_action(Action(1));
+    state.add_to_inventory(Element::kWood, 3);
+
+    std::vector<uint8_t> bytes(state.serialized_size() + 8);
+    const std::size_t num_bytes = state.serialize_into(bytes.data(), bytes.size());
+    bytes.resize(num_bytes);
+    if (num_bytes != state.serialized_size() || state.serialize() != bytes) {
+        fail("serialize_into");
+    }
+
+    const CraftWorldGameState state_copy(bytes.data(), num_bytes);
+    if (state != state_copy || state.get_hash() != state_copy.get_hash()) {
+        fail("serialize_into");
+    }
+
+    try {
+        (void)state.serialize_into(bytes.data(), num_bytes - 1);
+        fail("serialize_into");
+    } catch (const std::invalid_argument &) {
+    }
+}
+
+void test_snapshot() {
+    LevelRegistry registry;
+    CraftWorldGameState state(registry.add(kDefaultGameParams));
+    state.apply_action(Action(1));
+    state.apply_action(Action(4));
+    state.add_to_inventory(Element::kWood, 2);
+
+    const std::vector<uint8_t> bytes = state.snapshot();
+    if (bytes.size() != state.snapshot_size() || bytes.size() >= state.serialized_size()) {
+        fail("snapshot");
+    }
+
+    CraftWorldGameState state_copy = CraftWorldGameState::from_snapshot(bytes.data(), bytes.size(), registry);
+    if (state != state_copy || state.get_hash() != state_copy.get_hash() ||
+        state.get_agent_index() != state_copy.get_agent_index() || state.level_id() != state_copy.level_id()) {
+        fail("snapshot");
+    }
+    state.apply_action(Action(2));
+    state_copy.apply_action(Action(2));
+    if (state != state_copy || state.get_hash() != state_copy.get_hash()) {
+        fail("snapshot");
+    }
+
+    // Delta snapshots only store the cells changed since the start of the level
+    const std::vector<uint8_t> delta_bytes = state.snapshot(SnapshotGridEncoding::kDelta);
+    const CraftWorldGameState delta_copy =
+        CraftWorldGameState::from_snapshot(delta_bytes.data(), delta_bytes.size(), registry);
+    if (delta_bytes.size() >= bytes.size() || state != delta_copy || state.get_hash() != delta_copy.get_hash()) {
+        fail("snapshot");
+    }
+
+    // Levels need to be registered before their snapshots can be loaded
+    try {
+        (void)CraftWorldGameState::from_snapshot(bytes.data(), bytes.size(), LevelRegistry());
+        fail("snapshot");
+    } catch (const std::invalid_argument &) {
+    }
+
+    // Goals outside the recipe elements are rejected
+    std::vector<uint8_t> bad_goal = bytes;
+    bad_goal[offsetof(SnapshotHeader, goal)] = kNumElements;
+    try {
+        (void)CraftWorldGameState::from_snapshot(bad_goal.data(), bad_goal.size(), registry);
+        fail("snapshot goal");
+    } catch (const std::invalid_argument &) {
+    }
+
+    // Only inventory elements can have a count, as observations index inventory channels by element
+    std::vector<uint8_t> bad_inventory = bytes;
+    SnapshotHeader header;
+    std::memcpy(&header, bad_inventory.data(), sizeof(header));
+    header.inventory[0] = 1;
+    std::memcpy(bad_inventory.data(), &header, sizeof(header));
+    try {
+        (void)CraftWorldGameState::from_snapshot(bad_inventory.data(), bad_inventory.size(), registry);
+        fail("snapshot inventory");
+    } catch (const std::invalid_argument &) {
+    }
+    try {
+        const StateView view(bad_inventory.data(), bad_inventory.size());
+        fail("view inventory");
+    } catch (const std::invalid_argument &) {
+    }
+}
+
+void test_state_view() {
+    CraftWorldGameState state(kDefaultGameParams);
+    state.apply_action(Action(2));
+    state.add_to_inventory(Element::kWood, 2);
+    state.add_to_inventory(Element::kIron, 1);
+    const std::vector<uint8_t> bytes = state.snapshot();
+    const StateView view(bytes.data(), bytes.size());
+
+    if (view.get_hash() != state.get_hash() || view.get_agent_index() != state.get_agent_index() ||
+        view.check_inventory(Element::kWood) != 2 || view.check_inventory(Element::kIron) != 1 ||
+        view.is_solution() != state.is_solution() || view.level_id() != state.level_id()) {
+        fail("state view");
+    }
+
+    for (const auto layout : {ObservationLayout::kCHW, ObservationLayout::kHWC}) {
+        std::vector<float> obs(view.observation_size(ObservationType::kFull));
+        view.get_observation(obs.data(), ObservationType::kFull, layout);
+        if (obs != state.get_observation(layout)) {
+            fail("state view");
+        }
+        obs.resize(view.observation_size(ObservationType::kBinary));
+        view.get_observation(obs.data(), ObservationType::kBinary, layout);
+        if (obs != state.get_binary_observation(layout)) {
+            fail("state view");
+        }
+        obs.resize(view.observation_size(ObservationType::kEnvironment));
+        view.get_observation(obs.data(), ObservationType::kEnvironment, layout);
+        if (obs != state.get_observation_environment(layout)) {
+            fail("state view");
+        }
+    }
+}
+
+void test_archive() {
+    const std::string path = "test_archive.bin";
+    CraftWorldGameState state(LevelRegistry::instance().add(kDefaultGameParams));
+    std::vector<CraftWorldGameState> states;
+    {
+        StateArchiveWriter writer(path, SnapshotGridEncoding::kDelta);
+        for (int step = 0; step < 20; ++step) {
+            state.apply_action(Action(step % 5));
+            states.push_back(state);
+            writer.append(state);
+        }
+    }
+
+    const StateArchive archive(path);
+    if (archive.size() != states.size()) {
+        fail("archive");
+    }
+    std::size_t index = 0;
+    for (const StateView view : archive) {
+        if (view.get_hash() != states[index].get_hash() || archive.state(index) != states[index]) {
+            fail("archive");
+        }
+        ++index;
+    }
+    try {
+        (void)archive.view(archive.size());
+        fail("archive");
+    } catch (const std::out_of_range &) {
+    }
+
+    // Archives carry their levels, so records can be loaded after every other owner of the level is gone
+    {
+        LevelGeneratorConfig config;
+        config.map_size = 9;
+        CraftWorldGameState level_state(std::make_shared<const SharedStateInfo>(generate_level(config, 1), false));
+        level_state = CraftWorldGameState(LevelRegistry::instance().add(level_state.shared_state()));
+        level_state.apply_action(Action::kDown);
+        const uint64_t hash = level_state.get_hash();
+        {
+            StateArchiveWriter writer(path, SnapshotGridEncoding::kDelta, true);
+            writer.append(level_state);
+        }
+        level_state = CraftWorldGameState(kDefaultGameParams);
+        const StateArchive level_archive(path);
+        if (level_archive.state(0).get_hash() != hash) {
+            fail("archive level table");
+        }
+    }
+    {
+        StateArchiveWriter writer(path, SnapshotGridEncoding::kDelta);
+        for (const auto &archived : states) {
+            writer.append(archived);
+        }
+    }
+
+    // A corrupt record count in the footer must not overflow the index size check
+    std::vector<char> bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    // (2^61 + 1) * 8 wraps to 8, which would match an index of a single offset just before the footer
+    const uint64_t num_records = uint64_t{1} << 61;
+    const uint64_t index_offset = bytes.size() - 40 - 8;
+    std::memcpy(bytes.data() + bytes.size() - 40, &num_records, sizeof(num_records));
+    std::memcpy(bytes.data() + bytes.size() - 32, &index_offset, sizeof(index_offset));
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    try {
+        const StateArchive corrupt(path);
+        fail("archive footer");
+    } catch (const std::runtime_error &) {
+    }
+    std::remove(path.c_str());
+}
+
+void test_compression() {
+    CraftWorldGameState state(LevelRegistry::instance().add(kDefaultGameParams));
+    std::vector<CraftWorldGameState> states{state};
+    for (int step = 0; step < 30; ++step) {
+        state.apply_action(Action(step % 5));
+        states.push_back(state);
+    }
+
+    // Standalone snapshots in both grid encodings
+    for (const auto encoding : {SnapshotGridEncoding::kRaw, SnapshotGridEncoding::kDelta}) {
+        const std::vector<uint8_t> snapshot = state.snapshot(encoding);
+        std::vector<uint8_t> compressed;
+        compress_snapshot(snapshot.data(), snapshot.size(), compressed);
+        std::vector<uint8_t> decompressed;
+        if (compressed.size() >= snapshot.size() ||
+            decompress_snapshot(compressed.data(), compressed.size(), decompressed) != compressed.size() ||
+            decompressed != snapshot) {
+            fail("compression");
+        }
+    }
+
+    // Board dimensions beyond 16 bits are rejected instead of truncated
+    {
+        std::vector<uint8_t> compressed;
+        const std::vector<uint8_t> snapshot = state.snapshot();
+        compress_snapshot(snapshot.data(), snapshot.size(), compressed);
+        // Rows follow the coding tag, 65536 + rows truncates back to rows
+        std::vector<uint8_t> rows;
+        put_varint(65536 + compressed[1], rows);
+        compressed.erase(compressed.begin() + 1);
+        compressed.insert(compressed.begin() + 1, rows.begin(), rows.end());
+        try {
+            std::vector<uint8_t> decompressed;
+            (void)decompress_snapshot(compressed.data(), compressed.size(), decompressed);
+            fail("compression dimension");
+        } catch (const std::invalid_argument &) {
+        }
+    }
+
+    // Delta grids are whole entries, trailing bytes are rejected
+    std::vector<uint8_t> delta = state.snapshot(SnapshotGridEncoding::kDelta);
+    SnapshotHeader header;
+    std::memcpy(&header, delta.data(), sizeof(header));
+    ++header.grid_size;
+    std::memcpy(delta.data(), &header, sizeof(header));
+    delta.push_back(0);
+    try {
+        std::vector<uint8_t> compressed;
+        compress_snapshot(delta.data(), delta.size(), compressed);
+        fail("compression delta size");
+    } catch (const std::invalid_argument &) {
+    }
+
+    // Trajectory, each state coded against the previous one
+    const std::vector<uint8_t> trajectory = compress_trajectory(states);
+    const auto snapshots = decompress_trajectory(trajectory.data(), trajectory.size());
+    if (snapshots.size() != states.size()) {
+        fail("compression");
+    }
+    for (std::size_t i = 0; i < snapshots.size() && i < states.size(); ++i) {
+        if (CraftWorldGameState::from_snapshot(snapshots[i].data(), snapshots[i].size()) != states[i]) {
+            fail("compression");
+        }
+    }
+    try {
+        (void)decompress_trajectory(trajectory.data(), trajectory.size() / 2);
+        fail("compression");
+    } catch (const std::invalid_argument &) {
+    }
+
+    // Compressed archive
+    const std::string path = "test_compressed_archive.bin";
+    {
+        StateArchiveWriter writer(path, SnapshotGridEncoding::kDelta, true);
+        for (const auto &s : states) {
+            writer.append(s);
+        }
+    }
+    const StateArchive archive(path);
+    std::vector<uint8_t> snapshot;
+    for (std::size_t i = 0; i < archive.size(); ++i) {
+        archive.snapshot(i, snapshot);
+        if (!archive.compressed() || archive.state(i) != states[i] ||
+            StateView(snapshot.data(), snapshot.size()).get_hash() != states[i].get_hash()) {
+            fail("compression");
+        }
+    }
+    std::remove(path.c_str());
+}
+
+void test_trajectory_log() {
+    const std::string path = "test_trajectory_log.bin";
+    CraftWorldGameState state(LevelRegistry::instance().add(kDefaultGameParams));
+    std::vector<std::vector<CraftWorldGameState>> episodes(3);
+    {
+        TrajectoryLogWriter writer(path);
+        for (std::size_t i = 0; i < episodes.size(); ++i) {
+            state.reset();
+            writer.begin_episode(state);
+            episodes[i].push_back(state);
+            for (std::size_t step = 0; step < 10 * (i + 1); ++step) {
+                const auto action = Action((step * step + i) % kNumActions);
+                state.apply_action(action);
+                writer.add_step(action, state);
+                episodes[i].push_back(state);
+            }
+            writer.end_episode();
+        }
+        try {
+            writer.begin_episode(state);
+            fail("trajectory log");
+        } catch (const std::invalid_argument &) {
+        }
+    }
+
+    const TrajectoryReplayer replayer(path);
+    ThreadPool pool(2);
+    if (replayer.size() != episodes.size() || !replayer.verify(pool).empty()) {
+        fail("trajectory log");
+    }
+    for (std::size_t i = 0; i < replayer.size() && i < episodes.size(); ++i) {
+        const Trajectory trajectory = replayer.trajectory(i);
+        if (trajectory.actions.size() + 1 != episodes[i].size() || replayer.num_steps(i) + 1 != episodes[i].size() ||
+            trajectory.level_id != state.level_id()) {
+            fail("trajectory log");
+        }
+        for (std::size_t step = 0; step < episodes[i].size(); step += 3) {
+            if (replayer.state(i, step) != episodes[i][step]) {
+                fail("trajectory log");
+            }
+        }
+    }
+
+    // A board whose numbers overflow int is reported as a corrupt log, not as std::out_of_range
+    const std::string small_board_str = "2|2|15|00|26|26|26";
+    std::remove(path.c_str());
+    {
+        TrajectoryLogWriter writer(path);
+        writer.begin_episode(CraftWorldGameState(LevelRegistry::instance().add(small_board_str, false)));
+        writer.end_episode();
+    }
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        const std::string overflow_board_str = "99999999999|2|15|00|26|26|26";
+        const std::size_t board_pos = bytes.find(small_board_str);
+        bytes[board_pos - 1] = static_cast<char>(overflow_board_str.size());
+        bytes.replace(board_pos, small_board_str.size(), overflow_board_str);
+        std::ofstream out(path, std::ios::binary);
+        out << bytes;
+    }
+    try {
+        const TrajectoryReplayer corrupt(path);
+        fail("trajectory log");
+    } catch (const std::runtime_error &) {
+    }
+    std::remove(path.c_str());
+}
+
+void test_level_set() {
+    const std::string path = "test_level_set.txt";
+    const auto &board_str = std::get<std::string>(kDefaultGameParams.at("game_board_str"));
+    const std::string small_board_str = "2|2|15|00|26|26|26";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << board_str << "\n\n" << small_board_str << "\r\n" << "2|2|15|00|26|26" << "\n";
+    }
+
+    const LevelSet level_set(path);
+    if (level_set.size() != 3 || level_set.board_str(1) != small_board_str) {
+        fail("level set");
+    }
+    if (level_set.make_state(0) != CraftWorldGameState(kDefaultGameParams) ||
+        level_set.level(1) != level_set.level(1) || level_set.level(1)->initial_board.rows != 2) {
+        fail("level set");
+    }
+    try {
+        (void)level_set.level(2);
+        fail("level set");
+    } catch (const std::invalid_argument &) {
+    }
+    try {
+        (void)level_set.level(3);
+        fail("level set");
+    } catch (const std::out_of_range &) {
+    }
+
+    // Binary levelset
+    const std::string binary_path = "test_level_set.bin";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << board_str << "\n" << small_board_str << "\n";
+    }
+    const LevelSet text_set(path);
+    if (text_set.save_binary(binary_path) != 0) {
+        fail("level set");
+    }
+    const LevelSet binary_set(binary_path);
+    if (!binary_set.is_binary() || text_set.is_binary() || binary_set.size() != text_set.size()) {
+        fail("level set");
+    }
+    for (std::size_t i = 0; i < binary_set.size() && i < text_set.size(); ++i) {
+        const CraftWorldGameState state = binary_set.make_state(i);
+        if (binary_set.board_str(i) != text_set.board_str(i) || binary_set.level(i) != text_set.level(i) ||
+            state != text_set.make_state(i) || state.get_hash() != text_set.make_state(i).get_hash()) {
+            fail("level set");
+        }
+    }
+    std::remove(path.c_str());
+    std::remove(binary_path.c_str());
+}
+
+void test_interning() {
+    const CraftWorldGameState state1(kDefaultGameParams);
+    const CraftWorldGameState state2(kDefaultGameParams);
+    GameParameters params = kDefaultGameParams;
+    params["workshop_swap"] = GameParameter(true);
+    const CraftWorldGameState swapped(params);
+    if (state1.shared_state() != state2.shared_state() || state1.shared_state() == swapped.shared_state() ||
+        LevelRegistry::instance().find(swapped.level_id()) != swapped.shared_state()) {
+        fail("interning");
+    }
+
+    // Levels are only registered while they are alive
+    LevelRegistry registry;
+    uint64_t level_id = 0;
+    {
+        const auto level = registry.add(kDefaultGameParams);
+        level_id = level->level_id;
+        if (registry.find(level_id) != level || registry.size() != 1) {
+            fail("registry");
+        }
+    }
+    if (registry.find(level_id) != nullptr || registry.size() != 0) {
+        fail("registry release");
+    }
+
+    // Pinned levels stay registered without another owner
+    level_id = registry.pin(std::make_shared<const SharedStateInfo>(kDefaultGameParams))->level_id;
+    const bool pinned = registry.find(level_id) != nullptr;
+    if (!pinned || !registry.unpin(level_id) || registry.find(level_id) != nullptr) {
+        fail("registry pin");
+    }
+}
+
 int main() {
     test_serialization();
+    test_serialize_into();
+    test_snapshot();
+    test_state_view();
+    test_archive();
+    test_compression();
+    test_trajectory_log();
+    test_level_set();
+    test_interning();
+    return num_errors == 0 ? 0 : 1;
 }
@@ -0,0 +1,100 @@
+// Generate train and test levelsets, with the arguments and placement rules of scripts/generate_levelset.py.
+// Usage: craftworld_generate_levelset --export_path=PATH [--num_train=10000] [--num_test=1000] [--map_size=10]
+//            [--num_primitive=0] [--num_grass=0] [--hard=False] [--seed=0] [--num_threads=N]
+
+#include <craftworld/craftworld.h>
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace craftworld;
+
+namespace {
+// Parse --name=value and --name value arguments, a flag without a value is set to "True"
+auto parse_args(int argc, char **argv) -> std::unordered_map<std::string, std::string> {
+    std::unordered_map<std::string, std::string> args;
+    const std::vector<std::string> tokens(argv + 1, argv + argc);    // NOLINT(*-pointer-arithmetic)
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        const std::string &token = tokens[i];
+        if (token.rfind("--", 0) != 0) {
+            throw std::invalid_argument("Unexpected argument " + token);
+        }
+        const auto equals = token.find('=');
+        if (equals != std::string::npos) {
+            args[token.substr(2, equals - 2)] = token.substr(equals + 1);
+        } else if (i + 1 < tokens.size() && tokens[i + 1].rfind("--", 0) != 0) {
+            args[token.substr(2)] = tokens[++i];
+        } else {
+            args[token.substr(2)] = "True";
+        }
+    }
+    return args;
+}
+
+auto get_size(const std::unordered_map<std::string, std::string> &args, const std::string &name, std::size_t value)
+    -> std::size_t {
+    const auto it = args.find(name);
+    return it == args.end() ? value : static_cast<std::size_t>(std::stoull(it->second));
+}
+
+void write_levels(const std::filesystem::path &path, const std::vector<std::string> &levels) {
+    std::ofstream out(path);
+    for (const auto &level : levels) {
+        out << level << "\n";
+    }
+    if (!out) {
+        throw std::runtime_error("Unable to write " + path.string());
+    }
+}
+}    // namespace
+
+int main(int argc, char **argv) {
+    try {
+        const auto args = parse_args(argc, argv);
+        if (args.count("export_path") == 0) {
+            std::cerr << "Usage: " << argv[0] << " --export_path=PATH [--num_train=10000] [--num_test=1000] "
+                      << "[--map_size=10] [--num_primitive=0] [--num_grass=0] [--hard=False] [--seed=0] "
+                      << "[--num_threads=N]" << std::endl;
+            return 1;
+        }
+        const std::filesystem::path export_path = args.at("export_path");
+        const std::size_t num_train = get_size(args, "num_train", 10000);    // NOLINT(*-magic-numbers)
+        const std::size_t num_test = get_size(args, "num_test", 1000);       // NOLINT(*-magic-numbers)
+        const auto seed = static_cast<uint64_t>(get_size(args, "seed", 0));
+        const bool hard = args.count("hard") > 0 && args.at("hard") != "False" && args.at("hard") != "false" &&
+                          args.at("hard") != "0";
+
+        LevelGeneratorConfig config;
+        config.map_size = get_size(args, "map_size", config.map_size);
+        config.num_primitive = get_size(args, "num_primitive", config.num_primitive);
+        config.num_grass = get_size(args, "num_grass", config.num_grass);
+        ThreadPool pool(get_size(args, "num_threads", std::thread::hardware_concurrency()));
+
+        // Levels are seeded by their index, test levels follow the train levels
+        const auto start = std::chrono::steady_clock::now();
+        config.recipe_probs = hard ? kRecipeProbsHard : kRecipeProbsTrain;
+        const auto train_levels = generate_levels(config, seed, num_train, pool);
+        config.recipe_probs = kRecipeProbsTest;
+        const auto test_levels = generate_levels(config, seed + num_train, num_test, pool);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::filesystem::create_directories(export_path);
+        write_levels(export_path / "train.txt", train_levels);
+        write_levels(export_path / "test.txt", test_levels);
+        std::cout << "Generated " << num_train << " train and " << num_test << " test levels in " << elapsed.count()
+                  << "s on " << pool.num_threads() << " threads." << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
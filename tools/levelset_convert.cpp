@@ -0,0 +1,40 @@
+// Convert a text levelset (one board string per line) into the binary levelset format read by LevelSet.
+// Usage: craftworld_levelset_convert INPUT.txt OUTPUT.bin
+
+#include <craftworld/craftworld.h>
+
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace craftworld;
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " INPUT.txt OUTPUT.bin" << std::endl;
+        return 1;
+    }
+    const std::string input_path = argv[1];     // NOLINT(*-pointer-arithmetic)
+    const std::string output_path = argv[2];    // NOLINT(*-pointer-arithmetic)
+    try {
+        const auto start = std::chrono::steady_clock::now();
+        const LevelSet level_set(input_path);
+        if (level_set.is_binary()) {
+            std::cerr << input_path << " is already a binary levelset." << std::endl;
+            return 1;
+        }
+        const std::size_t num_reformatted = level_set.save_binary(output_path);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "Converted " << level_set.size() << " levels to " << output_path << " in " << elapsed.count()
+                  << "s." << std::endl;
+        if (num_reformatted > 0) {
+            std::cout << num_reformatted << " board strings were not in the generate_levelset.py format, so these "
+                      << "levels have a different level id in the binary levelset." << std::endl;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}